@@ -0,0 +1,121 @@
+#define _WIN32_WINNT 0x601 // Windows 7
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <cppnet/address.hpp>
+
+#ifdef _WIN32
+#include <ws2tcpip.h>
+#endif
+
+/*
+    compares net::from_chars/net::to_chars with inet_pton/inet_ntop,
+    on a mix of IPv4 and IPv6 addresses with ports
+*/
+
+using clock_type = std::chrono::steady_clock;
+
+template <typename F>
+void measure(const char *name, std::size_t count, F f)
+{
+    auto start = clock_type::now();
+    std::size_t checksum = f();
+    std::chrono::duration<double, std::nano> elapsed = clock_type::now() - start;
+    std::cout << name << ": " << elapsed.count() / count << " ns per address (" << checksum << ")\n";
+}
+
+int main(int argc, const char *argv[])
+{
+    std::size_t count = argc > 1 ? std::stoul(argv[1]) : 1000000;
+
+    std::mt19937 random { 42 };
+    std::vector<net::address> addresses;
+    for (std::size_t i = 0; i < count; ++i) {
+        if (i % 2) {
+            sockaddr_in in {};
+            in.sin_family = AF_INET;
+            in.sin_addr.s_addr = random();
+            in.sin_port = htons(static_cast<std::uint16_t>(random()));
+            addresses.emplace_back(reinterpret_cast<const sockaddr *>(&in), sizeof(in));
+        } else {
+            sockaddr_in6 in6 {};
+            in6.sin6_family = AF_INET6;
+            auto bytes = reinterpret_cast<unsigned char *>(&in6.sin6_addr);
+            for (int b = 0; b < 16; ++b)
+                bytes[b] = b < 8 || random() % 2 ? static_cast<unsigned char>(random()) : 0;
+            in6.sin6_port = htons(static_cast<std::uint16_t>(random()));
+            addresses.emplace_back(reinterpret_cast<const sockaddr *>(&in6), sizeof(in6));
+        }
+    }
+
+    std::vector<std::string> texts;
+    for (const net::address &addr : addresses) {
+        char buffer[net::max_ip_address_chars];
+        auto result = net::to_chars(std::begin(buffer), std::end(buffer), addr);
+        texts.emplace_back(buffer, result.ptr);
+    }
+
+    measure("inet_ntop + port", count, [&] {
+        std::size_t checksum = 0;
+        char buffer[net::max_ip_address_chars];
+        for (const net::address &addr : addresses) {
+            int size;
+            if (addr.family() == AF_INET) {
+                auto in = reinterpret_cast<const sockaddr_in *>(addr.address_pointer());
+                inet_ntop(AF_INET, &in->sin_addr, buffer, sizeof(buffer));
+                size = std::snprintf(buffer + std::strlen(buffer), 8, ":%u", ntohs(in->sin_port));
+            } else {
+                auto in6 = reinterpret_cast<const sockaddr_in6 *>(addr.address_pointer());
+                buffer[0] = '[';
+                inet_ntop(AF_INET6, &in6->sin6_addr, buffer + 1, sizeof(buffer) - 1);
+                size = std::snprintf(buffer + std::strlen(buffer), 8, "]:%u", ntohs(in6->sin6_port));
+            }
+            checksum += static_cast<std::size_t>(size);
+        }
+        return checksum;
+    });
+
+    measure("net::to_chars", count, [&] {
+        std::size_t checksum = 0;
+        char buffer[net::max_ip_address_chars];
+        for (const net::address &addr : addresses)
+            checksum += static_cast<std::size_t>(net::to_chars(std::begin(buffer), std::end(buffer), addr).ptr - buffer);
+        return checksum;
+    });
+
+    // inet_pton needs the host alone and NUL terminated, the port is parsed separately
+    measure("inet_pton + port", count, [&] {
+        std::size_t checksum = 0;
+        char host[net::max_ip_address_chars];
+        unsigned char bytes[16];
+        for (const std::string &text : texts) {
+            bool v6 = text[0] == '[';
+            std::size_t start = v6 ? 1 : 0;
+            std::size_t end = std::min(text.find(v6 ? ']' : ':'), text.size());
+            std::memcpy(host, text.data() + start, end - start);
+            host[end - start] = '\0';
+            checksum += inet_pton(v6 ? AF_INET6 : AF_INET, host, bytes);
+            std::size_t port = text.find(':', end);
+            if (port != std::string::npos)
+                checksum += std::strtoul(text.c_str() + port + 1, nullptr, 10) & 1;
+        }
+        return checksum;
+    });
+
+    measure("net::from_chars", count, [&] {
+        std::size_t checksum = 0;
+        net::address addr;
+        for (const std::string &text : texts) {
+            auto result = net::from_chars(text.data(), text.data() + text.size(), addr);
+            checksum += result.ec == std::errc {};
+            checksum += ntohs(reinterpret_cast<const sockaddr_in *>(addr.address_pointer())->sin_port) & 1;
+        }
+        return checksum;
+    });
+}
@@ -1,52 +1,52 @@
-#include <cppnet/getaddrinfo.hpp>
-#include <cppnet/socket.hpp>
+#include <cppnet/http_client.hpp>
 
 #include <iostream>
 #include <string_view>
 #include <string>
-#include <charconv>
+#include <vector>
 
 using namespace std::literals;
 
-constexpr auto request =
-    "GET / HTTP/1.1\r\n"
-    "Host: example.com\r\n"
-    "\r\n"sv;
-
 int main(int argc, const char** argv) try {
 
-    size_t max_bytes = 1024;
-
-    if (argc == 2) {
-        if (argv[1] == "-h"sv || argv[1] == "--help"sv) {
-            std::cout << "Usage:\n\t" << argv[0] << " [max bytes]\n\n";
-            return EXIT_SUCCESS;
-        }
-        auto [ptr, ec] = std::from_chars(argv[1], argv[1] + std::strlen(argv[1]), max_bytes);
-        if (ec != std::errc{}) {
-            std::cout << "Usage:\n\t" << argv[0] << " [max bytes]\n\n";
-            return EXIT_FAILURE;
-        }
-    }
-
-    std::clog << "Resolving..." << std::endl;
-    net::address_info ainfo = net::getaddrinfo("example.com", "80", AF_UNSPEC, SOCK_STREAM);
-    net::socket sock { ainfo.family(), ainfo.type(), ainfo.protocol() };
-
-    std::clog << "Connecting..." << std::endl;
-    sock.connect(ainfo.address());
+    std::string_view host = "example.com";
+    std::string_view service = "80";
+    std::string_view target = "/";
 
-    std::clog << "Sending request..." << std::endl;
-    sock.send(request);
-
-    
-    std::clog << "Receiving response..." << std::endl;
-    auto buff = std::make_unique<char[]>(max_bytes);
-    auto received = sock.recv(buff.get(), max_bytes);
-
-    std::clog << "Done.\n" << std::endl;
-
-    std::cout.write(buff.get(), received) << std::endl;
+    if (argc > 1 && (argv[1] == "-h"sv || argv[1] == "--help"sv)) {
+        std::cout << "Usage:\n\t" << argv[0] << " [host [port [target]]]\n\n";
+        return EXIT_SUCCESS;
+    }
+    if (argc > 1)
+        host = argv[1];
+    if (argc > 2)
+        service = argv[2];
+    if (argc > 3)
+        target = argv[3];
+
+    net::http::client client;
+
+    std::clog << "Requesting " << target << " from " << host << "..." << std::endl;
+    net::http::outgoing_request req;
+    req.target = target;
+    // the body is written as it's received, whatever its size
+    net::http::response_head head = client.send(host, service, req, [](std::string_view data) {
+        std::cout.write(data.data(), data.size());
+    });
+    std::cout << std::endl;
+
+    std::clog << "\n" << head.raw();
+
+    // the same connection is reused, and both requests are sent before reading the responses
+    std::clog << "Pipelining two HEAD requests..." << std::endl;
+    net::http::outgoing_request head_req;
+    head_req.method = "HEAD";
+    head_req.target = target;
+    std::vector<net::http::response_head> heads = client.send_batch(host, service, { head_req, head_req });
+    for (const net::http::response_head& h : heads)
+        std::clog << h.status() << " " << h->reason << ", Content-Length: " << h.header("Content-Length") << std::endl;
+
+    std::clog << "Done." << std::endl;
 } catch (std::system_error& e) {
     std::cerr << e.code().category().name()
               << " error (" << e.code().value() << "):\n\t"
@@ -0,0 +1,54 @@
+#include <cppnet/http_server.hpp>
+
+#include <charconv>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+using namespace std::literals;
+
+// Answers "/" with a greeting and anything else with what it understood of the request:
+//
+//     curl -i localhost:8080/echo -d 'some body'
+
+int main(int argc, const char** argv) try {
+    std::uint16_t port = 8080;
+    if (argc == 2) {
+        auto [ptr, ec] = std::from_chars(argv[1], argv[1] + std::strlen(argv[1]), port);
+        if (ec != std::errc {} || *ptr) {
+            std::cout << "Usage:\n\t" << argv[0] << " [port]\n\n";
+            return EXIT_FAILURE;
+        }
+    }
+    std::signal(SIGPIPE, SIG_IGN);
+
+    net::socket listener(AF_INET6, SOCK_STREAM, 0);
+    int enable = 1;
+    listener.setsockopt(SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+    listener.bind(net::address::from_ipv6(net::any_addr, port, 0, 0));
+    listener.listen(SOMAXCONN);
+
+    net::http::server server { std::move(listener), [](const net::http::request& req, std::string_view body, net::http::response_builder& res) {
+        if (req.target == "/"sv) {
+            res.header("Content-Type", "text/plain").finish("Hello from cppnet\n");
+            return;
+        }
+        std::string echo;
+        echo.append(req.method).append(" ").append(req.target).append(" HTTP/1.").append(std::to_string(req.minor_version)).append("\n");
+        for (const net::http::header& h : req.headers)
+            echo.append(h.name).append(": ").append(h.value).append("\n");
+        echo.append("\n").append(body);
+        res.header("Content-Type", "text/plain").finish(echo);
+    } };
+
+    std::clog << "Listening on " << server.listener().getsockname() << std::endl;
+    server.run();
+} catch (std::system_error& e) {
+    std::cerr << e.code().category().name()
+              << " error (" << e.code().value() << "):\n\t"
+              << e.what() << '\n';
+} catch (std::exception& e) {
+    std::cerr << "std exception:\n\t" << e.what() << '\n';
+}
@@ -0,0 +1,49 @@
+#include <cppnet/connect.hpp>
+#include <cppnet/getaddrinfo.hpp>
+#include <cppnet/tls.hpp>
+
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std::literals;
+
+int main(int argc, const char** argv) try {
+    std::string host = "example.com";
+    if (argc == 2) {
+        if (argv[1] == "-h"sv || argv[1] == "--help"sv) {
+            std::cout << "Usage:\n\t" << argv[0] << " [host]\n\n";
+            return EXIT_SUCCESS;
+        }
+        host = argv[1];
+    }
+
+    std::vector<net::address_info> addresses;
+    net::getaddrinfo(std::back_inserter(addresses), host.c_str(), "443", AF_UNSPEC, SOCK_STREAM);
+    net::socket sock = net::connect_happy_eyeballs(addresses.begin(), addresses.end(), {});
+
+    net::tls::context ctx { net::tls::context::role::client };
+    net::tls::stream stream { ctx, std::move(sock) };
+    stream.set_server_name(host);
+    stream.handshake();
+    std::clog << stream.version() << ", " << stream.cipher()
+              << ", kernel TLS for sending: " << (stream.ktls_send() ? "yes" : "no")
+              << ", for receiving: " << (stream.ktls_recv() ? "yes" : "no") << std::endl;
+
+    std::string request = "GET / HTTP/1.1\r\nHost: " + host + "\r\nConnection: close\r\n\r\n";
+    for (std::string_view rest = request; !rest.empty();)
+        rest.remove_prefix(stream.send(rest));
+
+    char buffer[16 * 1024];
+    while (std::size_t received = stream.recv(buffer, sizeof(buffer)))
+        std::cout.write(buffer, received);
+    std::cout << std::endl;
+} catch (std::system_error& e) {
+    std::cerr << e.code().category().name()
+              << " error (" << e.code().value() << "):\n\t"
+              << e.what() << '\n';
+} catch (std::exception& e) {
+    std::cerr << "std exception:\n\t" << e.what() << '\n';
+}
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <charconv> // std::from_chars_result, std::to_chars_result
 #include <cstdint> // UINT16_MAX
 #include <cstring> // std::memcpy
+#include <functional> // std::hash
 #include <iosfwd> // std::ostream
 #include <stdexcept> // class std::runtime_error
 #include <string_view> // class std::string_view
@@ -103,4 +105,54 @@ namespace net {
 
     std::ostream &operator<<(std::ostream &, net::address const &);
 
+    // Parses an IPv4 or IPv6 address with an optional port, as written by operator<<:
+    // 192.0.2.1, 192.0.2.1:80, 2001:db8::1, fe80::1%2, [2001:db8::1] and [fe80::1%2]:80.
+    // Like std::from_chars, [first, last) doesn't need to be NUL terminated and ptr is left past
+    // the address. ec is std::errc::invalid_argument when there's no address at first and
+    // std::errc::result_out_of_range for ports above 65535. Scope ids are numeric only.
+    std::from_chars_result from_chars(const char *first, const char *last, address &addr) noexcept;
+
+    // Writes what operator<< would, without allocating.
+    // ec is std::errc::value_too_large when it doesn't fit, max_ip_address_chars always fits IP addresses.
+    std::to_chars_result to_chars(char *first, char *last, address const &addr) noexcept;
+
+    constexpr std::size_t max_ip_address_chars = 64; // [ffff:ffff:ffff:ffff:ffff:ffff:255.255.255.255%4294967295]:65535
+
+    // Compares what identifies the endpoint: host, port and IPv6 scope id, or the path of unix addresses.
+    // The IPv6 flow info and the padding bytes are ignored.
+    bool operator==(address const &lhs, address const &rhs) noexcept;
+
+    inline bool operator!=(address const &lhs, address const &rhs) noexcept
+    {
+        return !(lhs == rhs);
+    }
+
+    // A total order consistent with ==, for sorted containers: by family, then the host in network
+    // byte order, the port and the IPv6 scope id, so that the addresses of a network are contiguous.
+    bool operator<(address const &lhs, address const &rhs) noexcept;
+
+    inline bool operator>(address const &lhs, address const &rhs) noexcept
+    {
+        return rhs < lhs;
+    }
+
+    inline bool operator<=(address const &lhs, address const &rhs) noexcept
+    {
+        return !(rhs < lhs);
+    }
+
+    inline bool operator>=(address const &lhs, address const &rhs) noexcept
+    {
+        return !(lhs < rhs);
+    }
+
 } // namespace net
+
+namespace std {
+
+    template <>
+    struct hash<net::address> {
+        std::size_t operator()(net::address const &addr) const noexcept;
+    };
+
+} // namespace std
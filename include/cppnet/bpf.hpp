@@ -0,0 +1,131 @@
+#pragma once
+#ifndef __linux__
+#error socket filters are only avilable in linux
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <system_error>
+#include <vector>
+
+#include <linux/filter.h>
+
+#include <cppnet/filtering_acceptor.hpp>
+#include <cppnet/socket.hpp>
+
+namespace net {
+
+// A classic BPF program, as taken by SO_ATTACH_FILTER and SO_ATTACH_REUSEPORT_CBPF
+class bpf_program {
+public:
+    bpf_program() noexcept = default;
+
+    bpf_program(std::initializer_list<sock_filter> instructions)
+        : m_instructions(instructions)
+    {
+    }
+
+    void push_back(const sock_filter& instruction)
+    {
+        m_instructions.push_back(instruction);
+    }
+
+    const std::vector<sock_filter>& instructions() const noexcept
+    {
+        return m_instructions;
+    }
+
+    std::size_t size() const noexcept
+    {
+        return m_instructions.size();
+    }
+
+    // points into this program, it must outlive the returned value
+    sock_fprog native() const noexcept
+    {
+        return { static_cast<unsigned short>(m_instructions.size()), const_cast<sock_filter*>(m_instructions.data()) };
+    }
+
+private:
+    std::vector<sock_filter> m_instructions;
+};
+
+// The program returns the index, in bind order, of the socket of the SO_REUSEPORT group
+// that gets the packet (or connection). Out of range indexes fall back to the default hashing.
+void attach_reuseport_filter(socket& sock, const bpf_program& program);
+void attach_reuseport_filter(socket& sock, const bpf_program& program, std::error_code&) noexcept;
+
+void detach_reuseport_filter(socket& sock);
+void detach_reuseport_filter(socket& sock, std::error_code&) noexcept;
+
+// SO_ATTACH_FILTER, the kernel drops what the program rejects before it's queued to the socket,
+// so rejected packets cost no wakeup, recv or copy.
+void attach_filter(socket& sock, const bpf_program& program);
+void attach_filter(socket& sock, const bpf_program& program, std::error_code&) noexcept;
+
+void detach_filter(socket& sock);
+void detach_filter(socket& sock, std::error_code&) noexcept;
+
+// SO_LOCK_FILTER, the attached filter can't be replaced or removed anymore
+void lock_filter(socket& sock);
+void lock_filter(socket& sock, std::error_code&) noexcept;
+
+// Builds a filter that accepts a packet only when every check holds.
+// Offsets and lengths are relative to the payload, the base offset is the size of what the
+// socket filter sees before it: the 8 byte UDP header for UDP sockets, nothing for packet sockets.
+// Multi-byte values are compared in network byte order, as loaded by BPF.
+//
+//     auto filter = net::bpf_filter_builder {}
+//         .length_between(8, 1472)
+//         .word_equals(0, 0xcafef00d) // magic
+//         .byte_equals(4, 2) // version
+//         .build();
+//     net::attach_filter(sock, filter);
+class bpf_filter_builder {
+public:
+    static constexpr std::uint32_t udp_payload = 8;
+
+    explicit bpf_filter_builder(std::uint32_t base = udp_payload) noexcept
+        : m_base { base }
+    {
+    }
+
+    bpf_filter_builder& length_between(std::uint32_t min, std::uint32_t max);
+
+    bpf_filter_builder& byte_equals(std::uint32_t offset, std::uint8_t value, std::uint8_t mask = 0xff);
+    bpf_filter_builder& half_equals(std::uint32_t offset, std::uint16_t value, std::uint16_t mask = 0xffff);
+    bpf_filter_builder& word_equals(std::uint32_t offset, std::uint32_t value, std::uint32_t mask = 0xffffffff);
+
+    bpf_filter_builder& byte_between(std::uint32_t offset, std::uint8_t min, std::uint8_t max);
+
+    // throws std::length_error if there are too many checks for the 8 bit BPF jumps
+    bpf_program build() const;
+
+private:
+    struct check {
+        std::uint16_t load; // BPF_LD | size | mode
+        std::uint32_t offset;
+        std::uint32_t mask;
+        std::uint32_t min; // equals when min == max
+        std::uint32_t max;
+    };
+
+    std::uint32_t m_base;
+    std::vector<check> m_checks;
+};
+
+// A socket filter deciding by the source address of the IPv4 or IPv6 header, with the rules
+// of a filtering_acceptor: the longest matching prefix, else the default action.
+// On a TCP listener the SYNs of denied peers are dropped before any handshake, on a UDP socket
+// their datagrams are. IPv4 packets reaching dual stack sockets are matched against the IPv4 rules.
+// These drops aren't counted by the acceptor, and it has to be attached again when the rules change.
+// throws std::length_error above BPF_MAXINSNS instructions, around a thousand rules.
+bpf_program source_filter(const std::vector<filter_rule>& rules, filter_action default_action);
+
+inline bpf_program source_filter(const filtering_acceptor& acceptor)
+{
+    return source_filter(acceptor.rules(), acceptor.default_action());
+}
+
+} // namespace net
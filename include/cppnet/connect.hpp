@@ -0,0 +1,181 @@
+#pragma once
+
+#include <chrono>
+#include <iterator>
+#include <new>
+#include <optional>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <cppnet/getaddrinfo.hpp>
+#include <cppnet/socket.hpp>
+
+namespace net {
+
+namespace detail {
+
+    // whether the poller reports why add failed, as net::epoll does
+    template <typename Poller, typename = void>
+    struct has_error_code_add : std::false_type {
+    };
+
+    template <typename Poller>
+    struct has_error_code_add<Poller, std::void_t<decltype(std::declval<Poller&>().add(socket::native_handle_type {}, 0, std::declval<std::error_code&>()))>>
+        : std::true_type {
+    };
+
+} // namespace detail
+
+// A non-blocking connect completed through a poller (net::epoll, net::poll or net::select)
+//
+//     net::async_connect op;
+//     if (!op.start(poller, sock, addr, 2s, e))
+//         ... run the loop, bounding its timeout with op.remaining()
+//     on any event of op.native_handle(): op.complete(poller, e)
+//     on every iteration: op.expire(poller, e)
+class async_connect {
+public:
+    using clock = std::chrono::steady_clock;
+
+    async_connect() noexcept = default;
+
+    async_connect(const async_connect&) = delete;
+    async_connect& operator=(const async_connect&) = delete;
+
+    // Makes the socket non-blocking and starts connecting it.
+    // Returns false while in progress, the socket is then registered in the poller for write readiness.
+    // Returns true when it finished already, connected or not, with the result in e.
+    // If the poller refused the socket, e says why but the connect is still in flight: close the socket.
+    template <typename Poller>
+    bool start(Poller& poller, socket& sock, const address& addr, std::optional<std::chrono::milliseconds> timeout, std::error_code& e) noexcept try {
+        if (start(sock, reinterpret_cast<const sockaddr*>(addr.address_pointer()), addr.address_size(), timeout, e))
+            return true;
+        if constexpr (detail::has_error_code_add<Poller>::value) {
+            if (poller.add(sock.native_handle(), Poller::write, e))
+                return false;
+        } else {
+            if (poller.add(sock.native_handle(), Poller::write))
+                return false;
+            e = std::make_error_code(std::errc::invalid_argument); // already registered, or not a valid descriptor
+        }
+        m_socket = nullptr;
+        return true;
+    } catch (const std::bad_alloc&) {
+        m_socket = nullptr;
+        e = std::make_error_code(std::errc::not_enough_memory);
+        return true;
+    }
+
+    // To be called when the poller reports any event for the socket, finishes the operation.
+    template <typename Poller>
+    void complete(Poller& poller, std::error_code& e) noexcept
+    {
+        if (m_socket)
+            poller.remove(m_socket->native_handle());
+        finish(e);
+    }
+
+    // Returns true, with std::errc::timed_out, when the deadline passed. The connect may still complete
+    // later: close the socket (or shut it down) instead of using it.
+    template <typename Poller>
+    bool expire(Poller& poller, std::error_code& e) noexcept
+    {
+        if (!m_socket || !m_deadline || clock::now() < *m_deadline)
+            return false;
+        poller.remove(m_socket->native_handle());
+        m_socket = nullptr;
+        e = std::make_error_code(std::errc::timed_out);
+        return true;
+    }
+
+    // the poller-less parts, for callers with their own readiness notification
+    bool start(socket& sock, const sockaddr* addr, size_t addr_size, std::optional<std::chrono::milliseconds> timeout, std::error_code& e) noexcept;
+    void finish(std::error_code& e) noexcept;
+
+    bool pending() const noexcept
+    {
+        return m_socket != nullptr;
+    }
+
+    socket::native_handle_type native_handle() const noexcept
+    {
+        return m_socket ? m_socket->native_handle() : socket::invalid_handle;
+    }
+
+    // time left until the deadline, to bound the poller timeout
+    std::optional<std::chrono::milliseconds> remaining() const noexcept;
+
+private:
+    socket* m_socket = nullptr;
+    std::optional<clock::time_point> m_deadline;
+};
+
+// Blocking connect with a deadline, fails with std::errc::timed_out. The socket is left in blocking mode.
+void connect(socket& sock, const address& addr, std::chrono::milliseconds timeout);
+void connect(socket& sock, const address& addr, std::chrono::milliseconds timeout, std::error_code&) noexcept;
+
+struct happy_eyeballs_options {
+    // RFC 8305 "Connection Attempt Delay", time given to an attempt before starting the next one
+    std::chrono::milliseconds attempt_delay = std::chrono::milliseconds(250);
+    // for the whole operation, fails with std::errc::timed_out
+    std::optional<std::chrono::milliseconds> timeout;
+    // mode of the returned socket, the attempts themselves are always non-blocking
+    bool blocking = true;
+};
+
+// what an attempt needs to know about an address
+struct connect_candidate {
+    int family;
+    int type;
+    int protocol;
+    const sockaddr* address;
+    size_t address_size;
+};
+
+inline connect_candidate make_connect_candidate(const address_info& ainfo) noexcept
+{
+    const net::address& addr = ainfo.address();
+    return { ainfo.family(), ainfo.type(), ainfo.protocol(), reinterpret_cast<const sockaddr*>(addr.address_pointer()), addr.address_size() };
+}
+
+inline connect_candidate make_connect_candidate(const address_info_view& ainfo) noexcept
+{
+    return { ainfo.family(), ainfo.type(), ainfo.protocol(), ainfo.address_pointer(), ainfo.address_size() };
+}
+
+// Happy Eyeballs (RFC 8305): interleaves the address families, starting with the family of the first candidate,
+// and starts a non-blocking connect every attempt_delay (or as soon as the previous attempt fails)
+// until one completes. The rest are closed. chosen, if not null, receives the index of the winner.
+socket connect_happy_eyeballs(const connect_candidate* candidates, std::size_t count, const happy_eyeballs_options& options, std::size_t* chosen, std::error_code&) noexcept;
+socket connect_happy_eyeballs(const connect_candidate* candidates, std::size_t count, const happy_eyeballs_options& options = {}, std::size_t* chosen = nullptr);
+
+// For the results of the iterator getaddrinfo overloads, or of an address_info_list
+template <typename It>
+socket connect_happy_eyeballs(It first, It last, const happy_eyeballs_options& options, It* chosen, std::error_code& e)
+{
+    std::vector<connect_candidate> candidates;
+    for (It it = first; it != last; ++it)
+        candidates.push_back(make_connect_candidate(*it));
+
+    std::size_t index = 0;
+    socket sock = connect_happy_eyeballs(candidates.data(), candidates.size(), options, &index, e);
+    if (chosen && !e) {
+        *chosen = first;
+        std::advance(*chosen, index);
+    }
+    return sock;
+}
+
+template <typename It>
+socket connect_happy_eyeballs(It first, It last, const happy_eyeballs_options& options = {}, It* chosen = nullptr)
+{
+    std::error_code e;
+    socket sock = connect_happy_eyeballs(first, last, options, chosen, e);
+    if (e)
+        throw std::system_error(e);
+    return sock;
+}
+
+} // namespace net
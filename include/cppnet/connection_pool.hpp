@@ -0,0 +1,138 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+
+#include <cppnet/address.hpp>
+#include <cppnet/socket.hpp>
+
+namespace net {
+
+// Keeps idle connected sockets around, keyed by the address they are connected to.
+// The pool must outlive every connection it handed out. It's safe to use from multiple threads.
+class connection_pool {
+public:
+    using clock = std::chrono::steady_clock;
+
+    struct options {
+        int type = SOCK_STREAM;
+        int protocol = 0;
+        std::size_t max_idle = 8; // idle connections kept per backend
+        std::size_t max_connections = 0; // idle plus checked out, per backend. Zero means unlimited
+        std::chrono::milliseconds max_idle_time = std::chrono::seconds(30);
+        std::chrono::milliseconds max_age = std::chrono::minutes(10); // zero means unlimited
+    };
+
+    // A checked out connection, goes back to the pool when destroyed unless discarded
+    class connection {
+    public:
+        connection() noexcept = default;
+
+        connection(connection&& rhs) noexcept;
+        connection& operator=(connection&& rhs) noexcept;
+
+        ~connection() noexcept
+        {
+            release();
+        }
+
+        net::socket& socket() noexcept
+        {
+            return m_socket;
+        }
+
+        net::socket* operator->() noexcept
+        {
+            return &m_socket;
+        }
+
+        const net::address& address() const noexcept
+        {
+            return m_address;
+        }
+
+        // whether it was taken from the idle list instead of being freshly connected
+        bool reused() const noexcept
+        {
+            return m_reused;
+        }
+
+        explicit operator bool() const noexcept
+        {
+            return static_cast<bool>(m_socket);
+        }
+
+        // gives the connection back to the pool, it must be idle: no pending request or unread response
+        void release() noexcept;
+
+        // closes the connection, after an error or when the protocol doesn't allow reusing it
+        void discard() noexcept;
+
+    private:
+        friend class connection_pool;
+
+        connection_pool* m_pool = nullptr;
+        net::address m_address;
+        net::socket m_socket;
+        clock::time_point m_created;
+        bool m_reused = false;
+    };
+
+    connection_pool()
+        : connection_pool(options {})
+    {
+    }
+
+    explicit connection_pool(options opts)
+        : m_options { opts }
+    {
+    }
+
+    connection_pool(const connection_pool&) = delete;
+    connection_pool& operator=(const connection_pool&) = delete;
+
+    // Takes the most recently used idle connection that's still alive, or connects a new one.
+    // Fails with std::errc::resource_unavailable_try_again if the backend reached max_connections.
+    connection acquire(const address& addr);
+    connection acquire(const address& addr, std::error_code&) noexcept;
+
+    // closes idle connections past max_idle_time or max_age, returns how many were closed
+    std::size_t prune() noexcept;
+
+    // closes every idle connection
+    void clear() noexcept;
+
+    std::size_t idle() const noexcept;
+    std::size_t idle(const address& addr) const noexcept;
+
+    const options& settings() const noexcept
+    {
+        return m_options;
+    }
+
+private:
+    struct idle_connection {
+        socket sock;
+        clock::time_point created;
+        clock::time_point idle_since;
+    };
+
+    struct backend {
+        std::vector<idle_connection> idle;
+        std::size_t live = 0; // idle and checked out
+    };
+
+    bool expired(clock::time_point now, clock::time_point created, clock::time_point idle_since) const noexcept;
+    void put_back(connection& conn) noexcept;
+    void forget(const address& addr) noexcept;
+
+    options m_options;
+    mutable std::mutex m_mutex;
+    std::unordered_map<address, backend> m_backends;
+};
+
+} // namespace net
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <cppnet/getaddrinfo.hpp>
+
+namespace net {
+
+// A thread safe cache in front of net::getaddrinfo.
+//
+// The cache is split in 64 shards by the hash of the name. Hits read an immutable snapshot of their
+// shard and never wait for writers, but loading it with std::atomic_load takes a short internal lock
+// (libstdc++ guards shared_ptr atomics with a pool of mutexes), so they aren't lock free. A miss or
+// a refresh copies only its shard to publish the answer. Misses for the same name are coalesced
+// into a single getaddrinfo call, and names that keep being used are refreshed by a background
+// thread before they expire.
+class dns_cache {
+public:
+    using clock = std::chrono::steady_clock;
+    using result = std::shared_ptr<const std::vector<address_info>>;
+
+    struct options {
+        // getaddrinfo doesn't tell the TTL of the records, this is used for every name instead
+        std::chrono::milliseconds ttl = std::chrono::seconds(60);
+        // for the errors of addrinfo_category(), EAI_NONAME and the like
+        std::chrono::milliseconds negative_ttl = std::chrono::seconds(5);
+        // names used within this time of their expiry are resolved again in the background
+        std::chrono::milliseconds refresh_ahead = std::chrono::seconds(10);
+        // expired entries are dropped first when it's full, then any; enforced per shard, each
+        // holding up to max_entries / 64, rounded up
+        std::size_t max_entries = 4096;
+    };
+
+    dns_cache();
+    explicit dns_cache(options opts);
+
+    dns_cache(const dns_cache&) = delete;
+    dns_cache& operator=(const dns_cache&) = delete;
+
+    // stops the refresh thread
+    ~dns_cache();
+
+    // same arguments as getaddrinfo, service may be empty
+    result resolve(std::string_view host, std::string_view service, int family = 0, int type = 0, int protocol = 0, int flags = 0);
+    result resolve(std::string_view host, std::string_view service, int family, int type, int protocol, int flags, std::error_code&);
+
+    // forgets everything, lookups in progress still complete
+    void clear();
+
+    std::size_t size() const;
+
+    const options& settings() const noexcept
+    {
+        return m_options;
+    }
+
+private:
+    struct key {
+        std::string host;
+        std::string service;
+        int family;
+        int type;
+        int protocol;
+        int flags;
+
+        bool operator==(const key& other) const noexcept
+        {
+            return host == other.host && service == other.service && family == other.family && type == other.type
+                && protocol == other.protocol && flags == other.flags;
+        }
+    };
+
+    struct key_hash {
+        std::size_t operator()(const key& k) const noexcept;
+    };
+
+    struct entry {
+        result addresses; // null on errors
+        std::error_code error;
+        clock::time_point expires;
+        clock::time_point refresh_at;
+        mutable std::atomic<bool> refreshing { false };
+    };
+
+    using entry_ptr = std::shared_ptr<const entry>;
+    using table = std::unordered_map<key, entry_ptr, key_hash>;
+
+    static constexpr std::size_t shard_count = 64;
+
+    struct alignas(64) shard {
+        std::shared_ptr<const table> entries; // read and replaced atomically
+    };
+
+    shard& shard_of(const key& k) noexcept;
+
+    entry_ptr lookup(const key& k);
+    entry_ptr fetch(const key& k);
+    void publish(const key& k, entry_ptr e);
+    void schedule_refresh(const key& k);
+    void refresh_loop();
+
+    options m_options;
+    std::array<shard, shard_count> m_shards;
+
+    std::mutex m_mutex; // writers and the in flight lookups
+    std::unordered_map<key, std::shared_future<entry_ptr>, key_hash> m_in_flight;
+
+    std::mutex m_refresh_mutex;
+    std::condition_variable m_refresh_wakeup;
+    std::vector<key> m_refresh_queue;
+    bool m_stopping = false;
+    std::thread m_refresher;
+};
+
+} // namespace net
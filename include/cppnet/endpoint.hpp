@@ -0,0 +1,236 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iosfwd>
+#include <type_traits>
+
+#ifdef _WIN32
+#include <ws2tcpip.h> // struct sockaddr_in6
+#endif
+
+#include <cppnet/address.hpp>
+
+// Compact IP endpoints, for tables of millions of peers where net::address and its
+// sockaddr_storage would take more than 130 bytes an entry.
+//
+// Both are trivially copyable arrays of bytes in network byte order, with an alignment of 1:
+// memcmp order is the order of the host, then the port (then the scope id), and they can be
+// stored packed or memcpy'd as they are. The IPv6 flow info isn't kept, as in address comparisons.
+
+namespace net {
+
+class endpoint_v4 {
+public:
+    constexpr endpoint_v4() noexcept = default;
+
+    // host in network byte order, as in in_addr
+    endpoint_v4(const std::array<std::uint8_t, 4>& host, std::uint16_t port) noexcept
+    {
+        std::memcpy(m_bytes, host.data(), 4);
+        m_bytes[4] = static_cast<std::uint8_t>(port >> 8);
+        m_bytes[5] = static_cast<std::uint8_t>(port);
+    }
+
+    explicit endpoint_v4(const sockaddr_in& addr) noexcept
+    {
+        std::memcpy(m_bytes, &addr.sin_addr, 4);
+        std::memcpy(m_bytes + 4, &addr.sin_port, 2);
+    }
+
+    // throws std::invalid_argument if it's not an IPv4 address
+    explicit endpoint_v4(const address& addr);
+
+    std::array<std::uint8_t, 4> host() const noexcept
+    {
+        return { m_bytes[0], m_bytes[1], m_bytes[2], m_bytes[3] };
+    }
+
+    std::uint16_t port() const noexcept
+    {
+        return static_cast<std::uint16_t>(m_bytes[4] << 8 | m_bytes[5]);
+    }
+
+    sockaddr_in native() const noexcept
+    {
+        sockaddr_in addr {};
+        addr.sin_family = AF_INET;
+        std::memcpy(&addr.sin_addr, m_bytes, 4);
+        std::memcpy(&addr.sin_port, m_bytes + 4, 2);
+        return addr;
+    }
+
+    address to_address() const noexcept;
+
+    const std::uint8_t* data() const noexcept
+    {
+        return m_bytes;
+    }
+
+    static constexpr std::size_t size() noexcept
+    {
+        return sizeof(m_bytes);
+    }
+
+private:
+    std::uint8_t m_bytes[6] {};
+};
+
+class endpoint_v6 {
+public:
+    constexpr endpoint_v6() noexcept = default;
+
+    // host in network byte order, as in in6_addr
+    endpoint_v6(const std::array<std::uint8_t, 16>& host, std::uint16_t port, std::uint32_t scope_id = 0) noexcept
+    {
+        std::memcpy(m_bytes, host.data(), 16);
+        m_bytes[16] = static_cast<std::uint8_t>(port >> 8);
+        m_bytes[17] = static_cast<std::uint8_t>(port);
+        store_scope(scope_id);
+    }
+
+    explicit endpoint_v6(const sockaddr_in6& addr) noexcept
+    {
+        std::memcpy(m_bytes, &addr.sin6_addr, 16);
+        std::memcpy(m_bytes + 16, &addr.sin6_port, 2);
+        store_scope(addr.sin6_scope_id);
+    }
+
+    // throws std::invalid_argument if it's not an IPv6 address
+    explicit endpoint_v6(const address& addr);
+
+    std::array<std::uint8_t, 16> host() const noexcept
+    {
+        std::array<std::uint8_t, 16> bytes;
+        std::memcpy(bytes.data(), m_bytes, 16);
+        return bytes;
+    }
+
+    std::uint16_t port() const noexcept
+    {
+        return static_cast<std::uint16_t>(m_bytes[16] << 8 | m_bytes[17]);
+    }
+
+    std::uint32_t scope_id() const noexcept
+    {
+        return std::uint32_t { m_bytes[18] } << 24 | std::uint32_t { m_bytes[19] } << 16 | std::uint32_t { m_bytes[20] } << 8 | m_bytes[21];
+    }
+
+    sockaddr_in6 native() const noexcept
+    {
+        sockaddr_in6 addr {};
+        addr.sin6_family = AF_INET6;
+        std::memcpy(&addr.sin6_addr, m_bytes, 16);
+        std::memcpy(&addr.sin6_port, m_bytes + 16, 2);
+        addr.sin6_scope_id = scope_id();
+        return addr;
+    }
+
+    address to_address() const noexcept;
+
+    const std::uint8_t* data() const noexcept
+    {
+        return m_bytes;
+    }
+
+    static constexpr std::size_t size() noexcept
+    {
+        return sizeof(m_bytes);
+    }
+
+private:
+    void store_scope(std::uint32_t scope_id) noexcept
+    {
+        m_bytes[18] = static_cast<std::uint8_t>(scope_id >> 24);
+        m_bytes[19] = static_cast<std::uint8_t>(scope_id >> 16);
+        m_bytes[20] = static_cast<std::uint8_t>(scope_id >> 8);
+        m_bytes[21] = static_cast<std::uint8_t>(scope_id);
+    }
+
+    std::uint8_t m_bytes[22] {}; // host, port and scope id
+};
+
+static_assert(sizeof(endpoint_v4) == 6 && alignof(endpoint_v4) == 1 && std::is_trivially_copyable_v<endpoint_v4>);
+static_assert(sizeof(endpoint_v6) == 22 && alignof(endpoint_v6) == 1 && std::is_trivially_copyable_v<endpoint_v6>);
+
+inline bool operator==(const endpoint_v4& a, const endpoint_v4& b) noexcept
+{
+    return std::memcmp(a.data(), b.data(), endpoint_v4::size()) == 0;
+}
+
+inline bool operator!=(const endpoint_v4& a, const endpoint_v4& b) noexcept
+{
+    return !(a == b);
+}
+
+inline bool operator<(const endpoint_v4& a, const endpoint_v4& b) noexcept
+{
+    return std::memcmp(a.data(), b.data(), endpoint_v4::size()) < 0;
+}
+
+inline bool operator>(const endpoint_v4& a, const endpoint_v4& b) noexcept
+{
+    return b < a;
+}
+
+inline bool operator<=(const endpoint_v4& a, const endpoint_v4& b) noexcept
+{
+    return !(b < a);
+}
+
+inline bool operator>=(const endpoint_v4& a, const endpoint_v4& b) noexcept
+{
+    return !(a < b);
+}
+
+inline bool operator==(const endpoint_v6& a, const endpoint_v6& b) noexcept
+{
+    return std::memcmp(a.data(), b.data(), endpoint_v6::size()) == 0;
+}
+
+inline bool operator!=(const endpoint_v6& a, const endpoint_v6& b) noexcept
+{
+    return !(a == b);
+}
+
+inline bool operator<(const endpoint_v6& a, const endpoint_v6& b) noexcept
+{
+    return std::memcmp(a.data(), b.data(), endpoint_v6::size()) < 0;
+}
+
+inline bool operator>(const endpoint_v6& a, const endpoint_v6& b) noexcept
+{
+    return b < a;
+}
+
+inline bool operator<=(const endpoint_v6& a, const endpoint_v6& b) noexcept
+{
+    return !(b < a);
+}
+
+inline bool operator>=(const endpoint_v6& a, const endpoint_v6& b) noexcept
+{
+    return !(a < b);
+}
+
+std::ostream& operator<<(std::ostream&, const endpoint_v4&);
+std::ostream& operator<<(std::ostream&, const endpoint_v6&);
+
+} // namespace net
+
+namespace std {
+
+template <>
+struct hash<net::endpoint_v4> {
+    std::size_t operator()(const net::endpoint_v4& endpoint) const noexcept;
+};
+
+template <>
+struct hash<net::endpoint_v6> {
+    std::size_t operator()(const net::endpoint_v6& endpoint) const noexcept;
+};
+
+} // namespace std
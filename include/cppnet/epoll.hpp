@@ -4,9 +4,11 @@
 #endif
 
 #include <chrono>
+#include <cstdint>
 #include <optional>
 #include <sys/epoll.h>
 #include <system_error>
+#include <utility>
 #include <vector>
 
 #include <cppnet/socket.hpp>
@@ -57,6 +59,47 @@ public:
     bool remove(socket::native_handle_type fd) noexcept;
     bool remove(socket::native_handle_type fd, std::error_code&) noexcept;
 
+    // Deferred changes, kqueue style: recorded without a system call, and applied by the next
+    // execute() right before it waits, or by apply_changes(). The changes to a descriptor are
+    // collapsed to their net effect: the last events win, an add then a remove cancel out, and a
+    // remove then an add become a modify. A descriptor removed by defer_remove() may be closed
+    // before the changes are applied, closing it removed it already. The immediate add(),
+    // modify() and remove() above drop the pending change of their descriptor, so the two can be
+    // mixed.
+    void defer_add(socket::native_handle_type fd, int events);
+    void defer_modify(socket::native_handle_type fd, int events);
+    void defer_remove(socket::native_handle_type fd);
+
+    // Returns how many epoll_ctl it took, the changes that failed are in change_errors()
+    std::size_t apply_changes() noexcept;
+
+    std::size_t pending_changes() const noexcept
+    {
+        return m_changes.size();
+    }
+
+    // The changes that failed when last applied, as { fd, error }
+    template <typename OIt>
+    OIt change_errors(OIt it) const noexcept(noexcept(*it = { 0, std::error_code {} }) && noexcept(++it))
+    {
+        for (const auto& [fd, error] : m_change_errors) {
+            *it = { fd, error };
+            ++it;
+        }
+        return it;
+    }
+
+    struct change_statistics {
+        std::uint64_t recorded; // deferred changes
+        std::uint64_t collapsed; // the ones merged into a pending change of the same descriptor
+        std::uint64_t applied; // epoll_ctl made for them
+    };
+
+    change_statistics change_stats() const noexcept
+    {
+        return m_change_stats;
+    }
+
     std::size_t execute(std::optional<std::chrono::milliseconds> milliseconds);
     std::size_t execute(std::optional<std::chrono::milliseconds> milliseconds, std::error_code&);
 
@@ -65,6 +108,49 @@ public:
 
     native_handle_type native_handle() const noexcept;
 
+    // Busy polling, trading a core for wakeup latency: execute() first polls with a zero timeout
+    // for up to budget (or its own timeout if shorter), and only blocks when nothing happened, for
+    // the rest of the timeout. Zero, the default, never spins.
+    void set_spin(std::chrono::microseconds budget) noexcept;
+
+    std::chrono::microseconds spin() const noexcept
+    {
+        return m_spin;
+    }
+
+    struct spin_statistics {
+        std::uint64_t polls; // zero timeout epoll_wait while spinning
+        std::uint64_t spun; // executions whose events were found while spinning
+        std::uint64_t slept; // executions that blocked
+        std::chrono::nanoseconds spinning; // time spent spinning
+    };
+
+    spin_statistics spin_stats() const noexcept
+    {
+        return m_spin_stats;
+    }
+
+    void reset_spin_stats() noexcept
+    {
+        m_spin_stats = {};
+    }
+
+    // The kernel side of busy polling (EPIOCSPARAMS, Linux 6.9): while blocked in execute(), the
+    // network devices' receive queues of the sockets added are polled for up to usecs before
+    // sleeping, budget packets at a time. Fails with std::errc::operation_not_supported on older
+    // kernels. Budgets above 64 need CAP_NET_ADMIN.
+    struct busy_poll_parameters {
+        std::chrono::microseconds usecs;
+        std::uint16_t budget;
+        bool prefer; // as SO_PREFER_BUSY_POLL
+    };
+
+    void set_busy_poll(const busy_poll_parameters& params);
+    void set_busy_poll(const busy_poll_parameters& params, std::error_code&) noexcept;
+
+    busy_poll_parameters busy_poll() const;
+    busy_poll_parameters busy_poll(std::error_code&) const noexcept;
+
     // ranges
     template <typename OIt>
     OIt get(OIt start, OIt stop) const noexcept(noexcept(*start = { 0, 0 }) && noexcept(++start == stop))
@@ -89,13 +175,70 @@ public:
         return it;
     }
 
+    // registered file descriptors
+    template <typename OIt>
+    OIt handles(OIt it) const noexcept(noexcept(*it = socket::native_handle_type {}) && noexcept(++it))
+    {
+        for (std::size_t fd = 0; fd < registered.size(); ++fd) {
+            if (registered[fd]) {
+                *it = static_cast<socket::native_handle_type>(fd);
+                ++it;
+            }
+        }
+        return it;
+    }
+
     void close();
     void close(std::error_code&) noexcept;
 
 protected:
     native_handle_type m_handle;
 private:
+    void track(socket::native_handle_type fd, bool active) noexcept;
+    int wait(std::optional<std::chrono::milliseconds> timeout, const sigset_t* sigmask) noexcept;
+
+    enum class change_op : unsigned char {
+        none, // an add and a remove that canceled out
+        add,
+        modify,
+        remove
+    };
+
+    struct change {
+        socket::native_handle_type fd;
+        int events;
+        change_op op;
+        bool readd = false; // a modify from a remove then an add, an add if the descriptor was closed since
+    };
+
+    void defer(socket::native_handle_type fd, change_op op, int events);
+    void forget_change(socket::native_handle_type fd) noexcept;
+
     std::vector<epoll_event> data;
+    std::vector<bool> registered; // indexed by file descriptor
     size_t size = 0;
+    std::chrono::microseconds m_spin { 0 };
+    spin_statistics m_spin_stats {};
+    std::vector<change> m_changes;
+    std::vector<std::size_t> m_change_slots; // indexed by file descriptor, 1 + its index in m_changes, 0 without one
+    std::vector<std::pair<socket::native_handle_type, std::error_code>> m_change_errors;
+    change_statistics m_change_stats {};
 };
+
+// Socket side busy polling, for blocking reads and for the poller when the kernel parameters of
+// the epoll aren't set:
+
+// SO_BUSY_POLL, how long a read polls the device queue before sleeping. Raising it above the
+// net.core.busy_read sysctl needs CAP_NET_ADMIN.
+void set_busy_poll(socket& sock, std::chrono::microseconds usecs);
+void set_busy_poll(socket& sock, std::chrono::microseconds usecs, std::error_code&) noexcept;
+
+// SO_PREFER_BUSY_POLL, keeps the device interrupts off while the application busy polls
+void set_prefer_busy_poll(socket& sock, bool prefer);
+void set_prefer_busy_poll(socket& sock, bool prefer, std::error_code&) noexcept;
+
+// SO_BUSY_POLL_BUDGET, packets per poll, above 64 needs CAP_NET_ADMIN
+void set_busy_poll_budget(socket& sock, int budget);
+void set_busy_poll_budget(socket& sock, int budget, std::error_code&) noexcept;
+
 } // net
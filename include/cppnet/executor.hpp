@@ -0,0 +1,198 @@
+#pragma once
+#ifndef __linux__
+#error the executor is only avilable in linux
+#endif
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <cppnet/submission_queue.hpp>
+
+namespace net {
+
+// what worker threads send back to an event loop, run by it with drain()
+using completion_queue = submission_queue<std::function<void()>>;
+
+namespace detail {
+
+    struct job {
+        std::function<void()> run;
+        job* next = nullptr; // in inboxes
+    };
+
+    // Chase-Lev deque, as in "Correct and Efficient Work-Stealing for Weak Memory Models"
+    // (Lê, Pop, Cohen, Zappa Nardelli, 2013): the owner pushes and takes at the bottom,
+    // thieves steal from the top.
+    class work_deque {
+    public:
+        explicit work_deque(std::size_t capacity);
+
+        work_deque(const work_deque&) = delete;
+        work_deque& operator=(const work_deque&) = delete;
+
+        // owner only
+        void push(job* j);
+        job* take() noexcept;
+
+        // any thread, nullptr when it's empty or another thief won
+        job* steal() noexcept;
+
+        bool empty() const noexcept
+        {
+            return m_top.load(std::memory_order_acquire) >= m_bottom.load(std::memory_order_acquire);
+        }
+
+    private:
+        struct ring {
+            explicit ring(std::size_t capacity)
+                : mask { capacity - 1 }
+                , slots { new std::atomic<job*>[capacity] }
+            {
+            }
+
+            std::size_t mask;
+            std::unique_ptr<std::atomic<job*>[]> slots;
+        };
+
+        ring* grow(ring* old, std::int64_t bottom, std::int64_t top);
+
+        alignas(64) std::atomic<std::int64_t> m_top { 0 };
+        alignas(64) std::atomic<std::int64_t> m_bottom { 0 };
+        std::atomic<ring*> m_ring;
+        std::vector<std::unique_ptr<ring>> m_rings; // the old ones too, thieves may still read them
+    };
+
+    // Lock free multiple producers list, whose consumer takes everything at once
+    class inbox {
+    public:
+        void push(job* j) noexcept
+        {
+            j->next = m_head.load(std::memory_order_relaxed);
+            while (!m_head.compare_exchange_weak(j->next, j, std::memory_order_seq_cst, std::memory_order_relaxed))
+                ;
+        }
+
+        // oldest first, linked by next
+        job* take_all() noexcept;
+
+        bool empty() const noexcept
+        {
+            return m_head.load() == nullptr;
+        }
+
+    private:
+        std::atomic<job*> m_head { nullptr };
+    };
+
+} // namespace detail
+
+// A work stealing thread pool, for the CPU heavy work that shouldn't run on event loops:
+//
+//     net::completion_queue completions; // polled by the loop, see submission_queue
+//     pool.dispatch(completions, fd, [req] { return render(req); }, [fd](std::string page) { send(fd, page); });
+//
+// Each worker has a Chase-Lev deque: tasks submitted from a worker go to its own deque, and idle
+// workers steal from the others', the nearest workers first. Tasks from other threads go to a
+// global injector, or with a hint (a connection's file descriptor or any id) to the inbox of
+// worker hint % size(), so that a connection's work keeps running on the same worker, and its
+// data in the same caches, while that worker isn't overloaded.
+//
+// Tasks must not throw. As they're std::function, what they capture must be copyable.
+class executor {
+public:
+    using task = std::function<void()>;
+
+    struct options {
+        std::size_t threads = std::thread::hardware_concurrency();
+        // workers pinned to the CPUs the process may run on, worker i to the i-th of them, so that
+        // near workers are on near cores
+        bool pin = false;
+        std::size_t deque_capacity = 256; // initially, they grow
+    };
+
+    executor();
+    explicit executor(options opts);
+
+    executor(const executor&) = delete;
+    executor& operator=(const executor&) = delete;
+
+    // runs what was submitted, then joins the workers
+    ~executor();
+
+    void submit(task t);
+    void submit(task t, std::size_t hint);
+
+    // Runs work on a worker, then done with what it returned on the loop that drains completions
+    template <typename Work, typename Done>
+    void dispatch(completion_queue& completions, std::size_t hint, Work work, Done done)
+    {
+        submit([&completions, work = std::move(work), done = std::move(done)]() mutable {
+            if constexpr (std::is_void_v<std::invoke_result_t<Work&>>) {
+                work();
+                completions.push(std::move(done));
+            } else {
+                completions.push([done = std::move(done), result = work()]() mutable { done(std::move(result)); });
+            }
+        },
+            hint);
+    }
+
+    std::size_t size() const noexcept
+    {
+        return m_workers.size();
+    }
+
+    // the index of the calling worker, size() on other threads
+    std::size_t current_worker() const noexcept;
+
+    struct statistics {
+        std::uint64_t executed;
+        std::uint64_t stolen;
+        std::uint64_t parked; // how many times workers ran out of work and slept
+    };
+
+    statistics stats() const noexcept;
+
+private:
+    struct worker {
+        explicit worker(std::size_t capacity)
+            : deque { capacity }
+        {
+        }
+
+        detail::work_deque deque;
+        detail::inbox inbox;
+        std::vector<std::size_t> victims; // the other workers, nearest first
+
+        std::mutex mutex;
+        std::condition_variable wakeup;
+        std::atomic<bool> sleeping { false };
+
+        std::atomic<std::uint64_t> executed { 0 };
+        std::atomic<std::uint64_t> stolen { 0 };
+        std::atomic<std::uint64_t> parked { 0 };
+        std::thread thread;
+    };
+
+    void run(std::size_t index);
+    detail::job* find_work(worker& self);
+    bool has_work(const worker& self) const noexcept;
+    bool wake(worker& w); // whether it was asleep
+    void wake_any();
+
+    std::vector<std::unique_ptr<worker>> m_workers;
+    detail::inbox m_injector;
+    std::atomic<std::size_t> m_sleepers { 0 };
+    std::atomic<bool> m_stopping { false };
+};
+
+} // namespace net
@@ -0,0 +1,44 @@
+#pragma once
+#ifndef __linux__
+#error TCP Fast Open is only avilable in linux
+#endif
+
+#include <array>
+#include <cstdint>
+#include <system_error>
+
+#include <netinet/tcp.h>
+
+#include <cppnet/address.hpp>
+#include <cppnet/socket.hpp>
+
+// TCP Fast Open (RFC 7413) must also be enabled system wide,
+// net.ipv4.tcp_fastopen is a bit mask: 1 enables clients, 2 enables servers.
+
+namespace net {
+
+using fastopen_key = std::array<std::uint8_t, 16>;
+
+// Enables TCP_FASTOPEN with queue_length pending Fast Open requests allowed, then listens.
+void listen_fastopen(socket& sock, int backlog, int queue_length);
+void listen_fastopen(socket& sock, int backlog, int queue_length, std::error_code&) noexcept;
+
+// Key used to generate the cookies of a listening socket, listeners sharing a port behind
+// SO_REUSEPORT (or across servers behind a load balancer) should use the same key.
+void set_fastopen_key(socket& sock, const fastopen_key& key);
+void set_fastopen_key(socket& sock, const fastopen_key& key, std::error_code&) noexcept;
+
+// Connects and sends data, inside the SYN when a cookie for the server is cached.
+// Without a cookie a blocking socket connects first and sends afterwards, as if connect() and send() were called.
+// On a non-blocking socket without a cookie it fails with std::errc::operation_in_progress and nothing is sent:
+// complete the connect (see net::async_connect::finish) and send the data again.
+// If the kernel has client Fast Open disabled it falls back to connect() and send().
+size_t connect_fastopen(socket& sock, const address& addr, const void* data, size_t size, int flags = 0);
+size_t connect_fastopen(socket& sock, const address& addr, const void* data, size_t size, int flags, std::error_code&) noexcept;
+
+// TCP_FASTOPEN_CONNECT: connect() returns right away and the first send() goes in the SYN.
+// Useful with code that can't be changed to use connect_fastopen.
+void enable_fastopen_connect(socket& sock);
+void enable_fastopen_connect(socket& sock, std::error_code&) noexcept;
+
+} // namespace net
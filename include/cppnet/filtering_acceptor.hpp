@@ -0,0 +1,134 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <vector>
+
+#include <cppnet/prefix_table.hpp>
+#include <cppnet/socket.hpp>
+
+namespace net {
+
+enum class filter_action {
+    allow,
+    deny,
+};
+
+struct filter_rule {
+    ip_prefix prefix;
+    filter_action action;
+};
+
+// Accepts the connections of a listening socket and drops those of denied peers before anything
+// else is done with them: no poller registration, no read, they're reset and closed at once.
+// The longest matching prefix decides, the default action when none matches.
+// IPv4 mapped peers (::ffff:a.b.c.d) of dual stack listeners are matched against the IPv4 rules.
+//
+// Rules can be changed while other threads accept, accept() reads an immutable snapshot of them.
+// On Linux, net::source_filter (bpf.hpp) turns the same rules into a socket filter that drops
+// the SYNs of denied peers in the kernel.
+class filtering_acceptor {
+public:
+    struct rule_counter {
+        filter_rule rule;
+        std::uint64_t hits; // connections it decided
+    };
+
+    explicit filtering_acceptor(socket& listener, filter_action default_action = filter_action::allow);
+
+    filtering_acceptor(const filtering_acceptor&) = delete;
+    filtering_acceptor& operator=(const filtering_acceptor&) = delete;
+
+    // replaces the action of an existing prefix, which keeps its counter
+    void add_rule(const ip_prefix& prefix, filter_action action);
+
+    void allow(const ip_prefix& prefix)
+    {
+        add_rule(prefix, filter_action::allow);
+    }
+
+    void deny(const ip_prefix& prefix)
+    {
+        add_rule(prefix, filter_action::deny);
+    }
+
+    // returns false if there was no rule for prefix
+    bool remove_rule(const ip_prefix& prefix);
+
+    // replaces every rule at once, the counters of the prefixes that stay are kept
+    void set_rules(const std::vector<filter_rule>& rules);
+
+    std::vector<filter_rule> rules() const;
+
+    filter_action default_action() const noexcept
+    {
+        return m_default_action;
+    }
+
+    // what accept() would do with a connection from peer, without counting it
+    filter_action check(const address& peer) const noexcept;
+
+    // Accepts until a connection is allowed, peer is its address.
+    // Non blocking listeners fail with std::errc::operation_would_block when only denied ones were pending.
+    socket accept(address& peer);
+    socket accept(address& peer, std::error_code&) noexcept;
+
+    std::vector<rule_counter> counters() const;
+
+    // connections no rule matched
+    std::uint64_t default_hits() const noexcept
+    {
+        return m_default_hits.load(std::memory_order_relaxed);
+    }
+
+    std::uint64_t accepted() const noexcept
+    {
+        return m_accepted.load(std::memory_order_relaxed);
+    }
+
+    std::uint64_t rejected() const noexcept
+    {
+        return m_rejected.load(std::memory_order_relaxed);
+    }
+
+    socket& listener() noexcept
+    {
+        return m_listener;
+    }
+
+private:
+    // shared by the snapshots, a replaced rule keeps its state so that no hit is lost
+    struct rule_state {
+        rule_state(const ip_prefix& p, filter_action a) noexcept
+            : prefix { p }
+            , action { a }
+        {
+        }
+
+        filter_rule rule() const noexcept
+        {
+            return { prefix, action.load(std::memory_order_relaxed) };
+        }
+
+        ip_prefix prefix;
+        std::atomic<filter_action> action;
+        std::atomic<std::uint64_t> hits { 0 };
+    };
+
+    using table = prefix_table<std::shared_ptr<rule_state>>;
+
+    socket& m_listener;
+    filter_action m_default_action;
+
+    std::mutex m_mutex; // rule changes
+    atomic_prefix_table<std::shared_ptr<rule_state>> m_table;
+
+    std::atomic<std::uint64_t> m_default_hits { 0 };
+    std::atomic<std::uint64_t> m_accepted { 0 };
+    std::atomic<std::uint64_t> m_rejected { 0 };
+};
+
+} // namespace net
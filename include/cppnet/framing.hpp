@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include <cppnet/socket.hpp>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#else
+#include <sys/uio.h>
+#endif
+
+namespace net {
+
+enum class byte_order {
+    big,
+    little,
+};
+
+// Frames made of a length header and that many bytes of payload
+struct frame_format {
+    std::size_t header_size = 4; // 2, 4 or 8
+    byte_order order = byte_order::big;
+    std::size_t max_frame_size = 16 * 1024 * 1024; // of payloads, larger ones are std::errc::message_size
+};
+
+// Writes the header of a length long payload to out, which has room for format.header_size bytes
+void encode_frame_header(char* out, std::uint64_t length, const frame_format& format) noexcept;
+std::uint64_t decode_frame_header(const char* in, const frame_format& format) noexcept;
+
+// Receives frames into one buffer and hands them out as views of it, without copying them:
+//
+//     while (reader.receive(sock)) {
+//         std::string_view frame;
+//         while (reader.next(frame))
+//             handle(frame);
+//     }
+//
+// Each receive() takes as much as fits in the buffer, which holds many frames, and the buffer
+// only grows for frames larger than it.
+class frame_reader {
+public:
+    // throws std::invalid_argument for header sizes but 2, 4 and 8
+    explicit frame_reader(frame_format format = {}, std::size_t buffer_size = 64 * 1024);
+
+    // One recv, the frames handed out before are no longer valid. Returns how much was received,
+    // 0 at the end of the stream.
+    std::size_t receive(socket& sock, int flags = 0);
+    std::size_t receive(socket& sock, int flags, std::error_code&);
+
+    // The next complete frame received, false when there's none yet. Frames larger than
+    // max_frame_size are std::errc::message_size, and can't be read past.
+    bool next(std::string_view& frame);
+    bool next(std::string_view& frame, std::error_code&) noexcept;
+
+    // received bytes not yet handed out, of incomplete frames
+    std::size_t buffered() const noexcept
+    {
+        return m_end - m_begin;
+    }
+
+    const frame_format& format() const noexcept
+    {
+        return m_format;
+    }
+
+private:
+    frame_format m_format;
+    std::vector<char> m_buffer;
+    std::size_t m_begin = 0;
+    std::size_t m_end = 0;
+};
+
+// Queues frames and sends them, headers and payloads, with vectored writes: one sendmsg for
+// as many frames as the system takes at once (IOV_MAX iovecs, 1024 in linux).
+// Payloads aren't copied, they must outlive the writer or the next clear().
+class frame_writer {
+public:
+    // throws std::invalid_argument for header sizes but 2, 4 and 8
+    explicit frame_writer(frame_format format = {});
+
+    // payloads larger than max_frame_size are std::errc::message_size
+    void push(std::string_view payload);
+    void push(std::string_view payload, std::error_code&);
+
+    // Sends the queued frames until they're all sent, or a would block error for non blocking
+    // sockets, after which flush() carries on where it stopped. Returns how much was sent.
+    std::size_t flush(socket& sock, int flags = 0);
+    std::size_t flush(socket& sock, int flags, std::error_code&) noexcept;
+
+    // queued bytes, headers included
+    std::size_t pending() const noexcept
+    {
+        return m_pending;
+    }
+
+    bool empty() const noexcept
+    {
+        return m_pending == 0;
+    }
+
+    // forgets the queued frames
+    void clear() noexcept;
+
+    const frame_format& format() const noexcept
+    {
+        return m_format;
+    }
+
+private:
+    struct queued {
+        char header[8];
+        std::string_view payload;
+    };
+
+    frame_format m_format;
+    std::vector<queued> m_frames; // their capacity is kept across flushes
+    std::size_t m_first = 0; // the first frame not sent entirely
+    std::size_t m_offset = 0; // of the first frame, header included
+    std::size_t m_pending = 0;
+#ifdef _WIN32
+    std::vector<WSABUF> m_pieces;
+#else
+    std::vector<iovec> m_pieces;
+#endif
+};
+
+} // namespace net
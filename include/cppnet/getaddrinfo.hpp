@@ -1,7 +1,11 @@
 #pragma once
 
+#include <cstddef>
+#include <iterator>
 #include <memory>
+#include <string_view>
 #include <system_error>
+#include <utility>
 
 #include <sys/types.h>
 
@@ -34,6 +38,7 @@ private:
     friend It getaddrinfo(It, It, const char*, const char*, int, int, int, int, std::error_code&) noexcept;
     template <typename It>
     friend It getaddrinfo(It, const char*, const char*, int, int, int, int, std::error_code&) noexcept;
+    friend class resolver;
 
     address_info(int, int, int, const sockaddr*, size_t, const char*) noexcept;
 
@@ -44,6 +49,181 @@ private:
     std::string m_canonname;
 };
 
+// One entry of an address_info_list, it points into the list and is valid as long as it
+class address_info_view {
+public:
+    address_info_view() noexcept = default;
+
+    explicit address_info_view(const ::addrinfo* info) noexcept
+        : m_info { info }
+    {
+    }
+
+    int family() const noexcept
+    {
+        return m_info->ai_family;
+    }
+
+    int type() const noexcept
+    {
+        return m_info->ai_socktype;
+    }
+
+    int protocol() const noexcept
+    {
+        return m_info->ai_protocol;
+    }
+
+    const sockaddr* address_pointer() const noexcept
+    {
+        return m_info->ai_addr;
+    }
+
+    std::size_t address_size() const noexcept
+    {
+        return m_info->ai_addrlen;
+    }
+
+    // a copy, for when it has to outlive the list
+    net::address address() const noexcept
+    {
+        return { m_info->ai_addr, m_info->ai_addrlen };
+    }
+
+    std::string_view canon_name() const noexcept
+    {
+        return m_info->ai_canonname ? std::string_view(m_info->ai_canonname) : std::string_view();
+    }
+
+    const ::addrinfo* native() const noexcept
+    {
+        return m_info;
+    }
+
+private:
+    const ::addrinfo* m_info = nullptr;
+};
+
+// Owns the ::addrinfo list returned by ::getaddrinfo and iterates it in place,
+// without copying the addresses nor allocating the canonical name of every entry.
+class address_info_list {
+public:
+    class iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = address_info_view;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const address_info_view*;
+        using reference = const address_info_view&;
+
+        iterator() noexcept = default;
+
+        explicit iterator(const ::addrinfo* info) noexcept
+            : m_view { info }
+        {
+        }
+
+        reference operator*() const noexcept
+        {
+            return m_view;
+        }
+
+        pointer operator->() const noexcept
+        {
+            return &m_view;
+        }
+
+        iterator& operator++() noexcept
+        {
+            m_view = address_info_view { m_view.native()->ai_next };
+            return *this;
+        }
+
+        iterator operator++(int) noexcept
+        {
+            iterator previous = *this;
+            ++*this;
+            return previous;
+        }
+
+        friend bool operator==(const iterator& a, const iterator& b) noexcept
+        {
+            return a.m_view.native() == b.m_view.native();
+        }
+
+        friend bool operator!=(const iterator& a, const iterator& b) noexcept
+        {
+            return !(a == b);
+        }
+
+    private:
+        address_info_view m_view;
+    };
+
+    using const_iterator = iterator;
+
+    address_info_list() noexcept = default;
+
+    // takes the ownership of a list returned by ::getaddrinfo
+    explicit address_info_list(::addrinfo* list) noexcept
+        : m_list { list }
+    {
+    }
+
+    address_info_list(const address_info_list&) = delete;
+    address_info_list& operator=(const address_info_list&) = delete;
+
+    address_info_list(address_info_list&& other) noexcept
+        : m_list { other.m_list }
+    {
+        other.m_list = nullptr;
+    }
+
+    address_info_list& operator=(address_info_list&& other) noexcept
+    {
+        std::swap(m_list, other.m_list);
+        return *this;
+    }
+
+    ~address_info_list() noexcept
+    {
+        if (m_list)
+            ::freeaddrinfo(m_list);
+    }
+
+    iterator begin() const noexcept
+    {
+        return iterator { m_list };
+    }
+
+    iterator end() const noexcept
+    {
+        return iterator {};
+    }
+
+    bool empty() const noexcept
+    {
+        return m_list == nullptr;
+    }
+
+    // walks the list
+    std::size_t size() const noexcept
+    {
+        return static_cast<std::size_t>(std::distance(begin(), end()));
+    }
+
+    const ::addrinfo* native() const noexcept
+    {
+        return m_list;
+    }
+
+private:
+    ::addrinfo* m_list = nullptr;
+};
+
+address_info_list getaddrinfo_list(const char* host, const char* service, int family = 0, int type = 0, int protocol = 0, int flags = 0);
+address_info_list getaddrinfo_list(const char* host, const char* service, int family, int type, int protocol, int flags, std::error_code&) noexcept;
+
 template <typename It>
 It getaddrinfo(It start, It stop, const char* node, const char* service, int family, int type, int protocol, int flags, std::error_code& e) noexcept
 {
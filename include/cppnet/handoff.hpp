@@ -0,0 +1,52 @@
+#pragma once
+#ifdef _WIN32
+#error socket handoff is only avilable in unix
+#endif
+
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <cppnet/socket.hpp>
+
+// Zero downtime restarts: the running process passes its listening (and established) sockets
+// to its successor over an AF_UNIX SOCK_SEQPACKET channel, so the accept queues are never dropped.
+//
+//   old process                                  new process
+//   auto server = net::handoff_listen(path);
+//   auto channel = net::handoff_accept(server);  auto channel = net::handoff_connect(path);
+//   net::send_handoff(channel, sockets);         auto sockets = net::recv_handoff(channel);
+//   stop accepting and close its copies          start accepting
+//
+// send_handoff returns once the successor acknowledged every socket, up to 1024 of them.
+// handoff_listen replaces a socket file left behind at path only when nothing listens on it
+// anymore, it fails with std::errc::address_in_use otherwise.
+
+namespace net {
+
+struct handoff_socket {
+    std::string name; // what the socket is for, e.g. "http" or "admin", up to 255 bytes
+    net::socket socket;
+};
+
+socket handoff_listen(std::string_view path, int backlog = 1);
+socket handoff_listen(std::string_view path, int backlog, std::error_code&) noexcept;
+
+// connects and says hello, so that handoff_accept knows it's a successor
+socket handoff_connect(std::string_view path);
+socket handoff_connect(std::string_view path, std::error_code&) noexcept;
+
+// Accepts the successor's channel, skipping the connections that close without a hello (like the
+// check of handoff_listen when another instance was started by mistake).
+socket handoff_accept(socket& server);
+socket handoff_accept(socket& server, std::error_code&) noexcept;
+
+void send_handoff(socket& channel, const std::vector<std::pair<std::string_view, socket::native_handle_type>>& sockets);
+void send_handoff(socket& channel, const std::vector<std::pair<std::string_view, socket::native_handle_type>>& sockets, std::error_code&) noexcept;
+
+std::vector<handoff_socket> recv_handoff(socket& channel);
+std::vector<handoff_socket> recv_handoff(socket& channel, std::error_code&);
+
+} // namespace net
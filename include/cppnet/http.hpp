@@ -0,0 +1,255 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+
+// HTTP/1.1 messages, RFC 9112.
+//
+// The parsers don't copy: every string_view of a parsed head points into the parsed buffer, which
+// must outlive them. Lines are scanned with SSE2, or AVX2 when the CPU has it, on x86-64.
+
+namespace net::http {
+
+enum class errc {
+    bad_request_line = 1,
+    bad_status_line,
+    bad_version,
+    bad_header,
+    too_many_headers,
+    bad_content_length,
+    bad_transfer_encoding,
+    bad_chunk,
+};
+
+const std::error_category& category() noexcept;
+
+// ASCII case insensitive comparison, for header names and the tokens of their values
+bool iequals(std::string_view a, std::string_view b) noexcept;
+
+inline std::error_code make_error_code(errc e) noexcept
+{
+    return { static_cast<int>(e), category() };
+}
+
+constexpr std::size_t max_headers = 64;
+
+struct header {
+    std::string_view name;
+    std::string_view value; // without the surrounding whitespace
+};
+
+class header_list {
+public:
+    const header* begin() const noexcept
+    {
+        return m_headers.data();
+    }
+
+    const header* end() const noexcept
+    {
+        return m_headers.data() + m_size;
+    }
+
+    std::size_t size() const noexcept
+    {
+        return m_size;
+    }
+
+    bool empty() const noexcept
+    {
+        return m_size == 0;
+    }
+
+    const header& operator[](std::size_t i) const noexcept
+    {
+        return m_headers[i];
+    }
+
+    // the value of the first header named name, case insensitively, empty if there's none
+    std::string_view find(std::string_view name) const noexcept;
+
+    void clear() noexcept
+    {
+        m_size = 0;
+    }
+
+    // false when it's full
+    bool push_back(const header& h) noexcept
+    {
+        if (m_size == max_headers)
+            return false;
+        m_headers[m_size++] = h;
+        return true;
+    }
+
+private:
+    std::array<header, max_headers> m_headers;
+    std::size_t m_size = 0;
+};
+
+// how the end of the body is found
+enum class body_framing {
+    none,
+    length, // content_length bytes
+    chunked, // see chunked_decoder
+    until_close, // responses only, the body ends with the connection
+};
+
+struct request {
+    std::string_view method;
+    std::string_view target;
+    int minor_version; // HTTP/1.minor_version
+    header_list headers;
+
+    body_framing framing;
+    std::uint64_t content_length; // for body_framing::length
+    bool keep_alive; // from the version and the Connection header
+};
+
+struct response {
+    int minor_version;
+    int status;
+    std::string_view reason;
+    header_list headers;
+
+    body_framing framing;
+    std::uint64_t content_length;
+    bool keep_alive;
+};
+
+// Parses the head of the message at the start of buffer: the start line and the headers.
+// Returns its size, where the body (or the next pipelined message) starts, or 0 when buffer
+// doesn't hold all of it yet. A request with both Content-Length and Transfer-Encoding is
+// refused, as it's a request smuggling vector.
+// The framing of responses to HEAD requests, and of CONNECT tunnels, is the caller's to adjust.
+std::size_t parse(std::string_view buffer, request& req);
+std::size_t parse(std::string_view buffer, request& req, std::error_code&) noexcept;
+
+std::size_t parse(std::string_view buffer, response& res);
+std::size_t parse(std::string_view buffer, response& res, std::error_code&) noexcept;
+
+// Decodes chunked bodies incrementally, without copying them:
+//
+//     while (!decoder.done()) {
+//         std::string_view data;
+//         std::size_t used = decoder.decode(input, data, e);
+//         if (e || used == 0)
+//             break; // error, or wait for more input
+//         consume(data); // a view into input
+//         input.remove_prefix(used);
+//     }
+//
+// Chunk extensions and trailers are skipped.
+class chunked_decoder {
+public:
+    // Consumes the start of input up to the end of the next piece of body data, which data points to.
+    // Returns how much was consumed, data may be empty when it's only chunk sizes and trailers.
+    std::size_t decode(std::string_view input, std::string_view& data, std::error_code&) noexcept;
+
+    // after the last chunk and the trailers
+    bool done() const noexcept
+    {
+        return m_state == state::done;
+    }
+
+    void reset() noexcept
+    {
+        m_state = state::size;
+        m_remaining = 0;
+        m_digits = 0;
+    }
+
+private:
+    enum class state {
+        size,
+        extension,
+        size_lf,
+        data,
+        data_cr,
+        data_lf,
+        trailer_start,
+        trailer,
+        end_lf,
+        done,
+    };
+
+    state m_state = state::size;
+    std::uint64_t m_remaining = 0;
+    int m_digits = 0;
+};
+
+// Appends a response to a string, Content-Length is added from the body:
+//
+//     http::response_builder { out }.status(404).header("Content-Type", "text/plain").finish("not found\n");
+class response_builder {
+public:
+    explicit response_builder(std::string& out) noexcept
+        : m_out { out }
+    {
+    }
+
+    // without a reason, the standard one is used. Must come before the headers
+    response_builder& status(int code, std::string_view reason = {});
+
+    response_builder& header(std::string_view name, std::string_view value);
+
+    // adds "Connection: close" when false
+    response_builder& keep_alive(bool enabled) noexcept
+    {
+        m_keep_alive = enabled;
+        return *this;
+    }
+
+    // the Content-Length of body is sent, but not body, as for HEAD requests
+    response_builder& head_only(bool enabled) noexcept
+    {
+        m_head_only = enabled;
+        return *this;
+    }
+
+    void finish(std::string_view body = {});
+
+    bool finished() const noexcept
+    {
+        return m_finished;
+    }
+
+    bool keeps_alive() const noexcept
+    {
+        return m_keep_alive;
+    }
+
+    int status_code() const noexcept
+    {
+        return m_status;
+    }
+
+private:
+    void start_line();
+
+    std::string& m_out;
+    int m_status = 200;
+    std::string_view m_reason;
+    bool m_started = false;
+    bool m_finished = false;
+    bool m_keep_alive = true;
+    bool m_head_only = false;
+};
+
+// "OK" for 200, and so on, empty for unknown codes
+std::string_view reason_phrase(int status) noexcept;
+
+} // namespace net::http
+
+namespace std {
+
+template <>
+struct is_error_code_enum<net::http::errc> : true_type {
+};
+
+} // namespace std
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include <cppnet/connection_pool.hpp>
+#include <cppnet/dns_cache.hpp>
+#include <cppnet/http.hpp>
+
+namespace net::http {
+
+// The head of a received response, it owns the bytes its string_views point to
+class response_head {
+public:
+    response_head() noexcept = default;
+
+    response_head(const response_head& rhs);
+    response_head& operator=(const response_head& rhs);
+
+    // the views are copied along, moving a short string may not keep its buffer
+    response_head(response_head&& rhs)
+        : response_head(static_cast<const response_head&>(rhs))
+    {
+    }
+
+    response_head& operator=(response_head&& rhs)
+    {
+        return *this = static_cast<const response_head&>(rhs);
+    }
+
+    const response& get() const noexcept
+    {
+        return m_response;
+    }
+
+    const response* operator->() const noexcept
+    {
+        return &m_response;
+    }
+
+    int status() const noexcept
+    {
+        return m_response.status;
+    }
+
+    // the value of the first header named name, case insensitively, empty if there's none
+    std::string_view header(std::string_view name) const noexcept
+    {
+        return m_response.headers.find(name);
+    }
+
+    // the bytes of the status line and the headers
+    std::string_view raw() const noexcept
+    {
+        return m_raw;
+    }
+
+private:
+    friend class client;
+
+    void assign(std::string_view raw, const response& parsed);
+
+    std::string m_raw;
+    response m_response {};
+};
+
+struct outgoing_request {
+    std::string_view method = "GET";
+    std::string_view target = "/";
+    std::vector<header> headers; // Host and Content-Length are added
+    std::string_view body;
+};
+
+// A thread safe HTTP/1.1 client that keeps connections alive per host, with a connection_pool
+// and a dns_cache in front of getaddrinfo.
+//
+// Each request's head and body are sent with one vectored write (sendmsg), without copying the body.
+// Response bodies are streamed to a sink as they're received, in views of the client's receive
+// buffer that are valid during the call, there's no limit on their size.
+//
+// send_batch() pipelines consecutive idempotent requests on one connection, up to max_pipeline
+// at once and in one write, and retries those the server closed the connection on without answering.
+// Other methods (POST, PATCH) are sent one at a time, and never retried.
+class client {
+public:
+    using body_sink = std::function<void(std::string_view)>;
+    using batch_sink = std::function<void(std::size_t index, std::string_view)>;
+
+    struct options {
+        connection_pool::options pool {};
+        dns_cache::options dns {};
+        std::size_t max_pipeline = 16;
+        std::size_t max_head_size = 64 * 1024;
+        std::size_t read_size = 16 * 1024;
+        std::chrono::milliseconds timeout = std::chrono::seconds(30); // of each send and recv, zero for none
+    };
+
+    client()
+        : client(options {})
+    {
+    }
+
+    explicit client(options opts);
+
+    client(const client&) = delete;
+    client& operator=(const client&) = delete;
+
+    // service is a port number or a name as "http"
+    response_head send(std::string_view host, std::string_view service, const outgoing_request& req, const body_sink& sink = {});
+    response_head send(std::string_view host, std::string_view service, const outgoing_request& req, const body_sink& sink, std::error_code&);
+
+    // appends the body to body
+    response_head get(std::string_view host, std::string_view service, std::string_view target, std::string& body);
+    response_head get(std::string_view host, std::string_view service, std::string_view target, std::string& body, std::error_code&);
+
+    // The responses, in the order of the requests. On errors, those before the failed one are complete.
+    std::vector<response_head> send_batch(std::string_view host, std::string_view service, const std::vector<outgoing_request>& requests, const batch_sink& sink = {});
+    std::vector<response_head> send_batch(std::string_view host, std::string_view service, const std::vector<outgoing_request>& requests, const batch_sink& sink, std::error_code&);
+
+    // GET, HEAD, PUT, DELETE, OPTIONS and TRACE
+    static bool idempotent(std::string_view method) noexcept;
+
+    connection_pool& pool() noexcept
+    {
+        return m_pool;
+    }
+
+    dns_cache& resolver() noexcept
+    {
+        return m_dns;
+    }
+
+    const options& settings() const noexcept
+    {
+        return m_options;
+    }
+
+private:
+    class reader;
+
+    std::vector<response_head> batch(std::string_view host, std::string_view service, const outgoing_request* requests, std::size_t count, const batch_sink& sink, std::error_code&);
+    connection_pool::connection connect(const dns_cache::result& addresses, std::error_code&) noexcept;
+    void write(connection_pool::connection& conn, std::string_view host, std::string_view service, const outgoing_request* requests, std::size_t count, std::error_code&);
+    bool read(connection_pool::connection& conn, reader& in, const outgoing_request& req, response_head& head, std::size_t index, const batch_sink& sink, std::error_code&);
+
+    options m_options;
+    connection_pool m_pool;
+    dns_cache m_dns;
+};
+
+} // namespace net::http
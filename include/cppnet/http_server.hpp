@@ -0,0 +1,113 @@
+#pragma once
+#ifndef __linux__
+#error the HTTP server is only avilable in linux
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <cppnet/epoll.hpp>
+#include <cppnet/http.hpp>
+#include <cppnet/socket.hpp>
+
+namespace net::http {
+
+// A minimal single threaded HTTP/1.1 server on net::epoll: keep alive, pipelining, Content-Length
+// and chunked request bodies, Expect: 100-continue. The handler is called once per request, in
+// order, with views into the receive buffer, and writes its response with the builder:
+//
+//     net::http::server server { std::move(listener), [](const net::http::request& req, std::string_view body, net::http::response_builder& res) {
+//         res.header("Content-Type", "text/plain").finish("hello\n");
+//     } };
+//     server.run();
+//
+// Responses the handler doesn't finish are sent empty. When it throws, a 500 is sent instead and
+// the connection is closed. Malformed requests get a 400 and close the connection.
+class server {
+public:
+    using handler = std::function<void(const request&, std::string_view body, response_builder&)>;
+
+    struct options {
+        std::size_t max_head_size = 64 * 1024; // 431 beyond
+        std::size_t max_body_size = 8 * 1024 * 1024; // 413 beyond
+        std::size_t read_size = 16 * 1024; // asked from each recv
+    };
+
+    // listener must be listening, it's made non blocking
+    server(socket listener, handler h);
+    server(socket listener, handler h, options opts);
+
+    server(const server&) = delete;
+    server& operator=(const server&) = delete;
+
+    ~server() noexcept;
+
+    // waits up to timeout for events, and handles them. Returns how many there were
+    std::size_t run_once(std::optional<std::chrono::milliseconds> timeout);
+    std::size_t run_once(std::optional<std::chrono::milliseconds> timeout, std::error_code&);
+
+    // until stop()
+    void run();
+    void run(std::error_code&);
+
+    // from any thread, run() returns after the events at hand
+    void stop() noexcept;
+
+    std::size_t connections() const noexcept
+    {
+        return m_connections.size();
+    }
+
+    socket& listener() noexcept
+    {
+        return m_listener;
+    }
+
+private:
+    struct connection {
+        socket sock;
+        std::vector<char> in;
+        std::size_t in_begin = 0;
+        std::size_t in_end = 0;
+        std::string out;
+        std::size_t out_sent = 0;
+        // the request at in_begin while its body arrives, parsed once, views into in
+        request req;
+        std::size_t head_size = 0; // 0 when it isn't parsed yet
+        // its chunked body, decoded as it arrives
+        std::string body;
+        chunked_decoder decoder;
+        std::size_t chunked_size = 0; // what decoder consumed after the head
+        bool closing = false; // after what's in out
+        bool writing = false; // waiting for epoll::write
+        bool continue_sent = false;
+    };
+
+    void accept_all();
+    void on_readable(int fd, connection& c);
+    void process(connection& c);
+    bool flush(int fd, connection& c); // false when the connection is done
+    void fail(connection& c, int status);
+    void drop(int fd);
+
+    socket m_listener;
+    handler m_handler;
+    options m_options;
+    epoll m_poller;
+    int m_wakeup = -1; // eventfd
+    std::atomic<bool> m_stopping { false };
+    std::unordered_map<int, connection> m_connections;
+    std::vector<std::pair<int, std::uint32_t>> m_events;
+};
+
+} // namespace net::http
@@ -81,6 +81,17 @@ public:
         return it;
     }
 
+    // registered file descriptors
+    template <typename OIt>
+    OIt handles(OIt it) const noexcept(noexcept(*it = socket::native_handle_type {}) && noexcept(++it))
+    {
+        for (const pollfd& fd : fds) {
+            *it = fd.fd;
+            ++it;
+        }
+        return it;
+    }
+
 private:
     std::vector<pollfd> fds;
 };
@@ -0,0 +1,404 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include <cppnet/address.hpp>
+
+namespace net {
+
+// An IPv4 or IPv6 network, e.g. 10.0.0.0/8 or 2001:db8::/32. The host bits are always zero.
+class ip_prefix {
+public:
+    ip_prefix() noexcept = default;
+
+    // throws std::invalid_argument for non IP addresses, or lengths over 32 (IPv4) or 128 (IPv6)
+    ip_prefix(const address& addr, unsigned length);
+
+    int family() const noexcept
+    {
+        return m_family;
+    }
+
+    unsigned length() const noexcept
+    {
+        return m_length;
+    }
+
+    // in network byte order, the first 4 for IPv4
+    const std::array<std::uint8_t, 16>& bytes() const noexcept
+    {
+        return m_bytes;
+    }
+
+    bool contains(const address& addr) const noexcept;
+
+    // with port 0
+    address network() const noexcept;
+
+private:
+    std::array<std::uint8_t, 16> m_bytes {};
+    std::uint16_t m_family = 0;
+    std::uint8_t m_length = 0;
+};
+
+bool operator==(const ip_prefix& a, const ip_prefix& b) noexcept;
+
+inline bool operator!=(const ip_prefix& a, const ip_prefix& b) noexcept
+{
+    return !(a == b);
+}
+
+// by family, then network, then length
+bool operator<(const ip_prefix& a, const ip_prefix& b) noexcept;
+
+// "192.0.2.0/24", "2001:db8::/32", an address without a length is a host prefix.
+// ec is std::errc::invalid_argument when there's no prefix at first, and std::errc::result_out_of_range
+// for lengths too long for the family.
+std::from_chars_result from_chars(const char* first, const char* last, ip_prefix& prefix) noexcept;
+std::to_chars_result to_chars(char* first, char* last, const ip_prefix& prefix) noexcept;
+
+std::ostream& operator<<(std::ostream&, const ip_prefix&);
+
+namespace detail {
+
+    // an IP address as a 128 bit number, IPv4 in the 32 high bits
+    struct prefix_key {
+        std::uint64_t high;
+        std::uint64_t low;
+    };
+
+    prefix_key make_prefix_key(const sockaddr_storage* addr) noexcept;
+    prefix_key make_prefix_key(const ip_prefix& prefix) noexcept;
+
+    inline unsigned bit_at(const prefix_key& key, unsigned index) noexcept
+    {
+        return index < 64 ? (key.high >> (63 - index)) & 1 : (key.low >> (127 - index)) & 1;
+    }
+
+    inline bool prefix_matches(const prefix_key& a, const prefix_key& b, unsigned length) noexcept
+    {
+        std::uint64_t high_mask = length == 0 ? 0 : length >= 64 ? ~std::uint64_t {} : ~std::uint64_t {} << (64 - length);
+        std::uint64_t low_mask = length <= 64 ? 0 : length >= 128 ? ~std::uint64_t {} : ~std::uint64_t {} << (128 - length);
+        return ((a.high ^ b.high) & high_mask) == 0 && ((a.low ^ b.low) & low_mask) == 0;
+    }
+
+    inline unsigned leading_zeros(std::uint64_t x) noexcept
+    {
+#ifdef _MSC_VER
+        unsigned long index;
+        return _BitScanReverse64(&index, x) ? 63 - index : 64;
+#else
+        return x ? static_cast<unsigned>(__builtin_clzll(x)) : 64;
+#endif
+    }
+
+    inline unsigned common_length(const prefix_key& a, const prefix_key& b) noexcept
+    {
+        if (std::uint64_t x = a.high ^ b.high)
+            return leading_zeros(x);
+        return 64 + leading_zeros(a.low ^ b.low);
+    }
+
+} // namespace detail
+
+// Longest prefix match of IPv4 and IPv6 addresses, a path compressed binary trie (PATRICIA)
+// whose nodes are stored in one array, so a lookup only touches the nodes of the matching path.
+//
+// Meant to be built (or copied and modified) aside and published with atomic_prefix_table,
+// lookups of a table that isn't modified anymore are safe from any number of threads.
+template <typename T>
+class prefix_table {
+public:
+    prefix_table()
+    {
+        m_nodes.push_back({ { 0, 0 }, 0, { -1, -1 }, -1 }); // IPv4 root, 0.0.0.0/0
+        m_nodes.push_back({ { 0, 0 }, 0, { -1, -1 }, -1 }); // IPv6 root, ::/0
+    }
+
+    // replaces the value of an existing prefix
+    void insert(const ip_prefix& prefix, T value)
+    {
+        std::int32_t& slot = find_or_add(prefix);
+        if (slot >= 0) {
+            m_values[slot].second = std::move(value);
+            return;
+        }
+        m_values.emplace_back(prefix, std::move(value));
+        slot = static_cast<std::int32_t>(m_values.size() - 1); // only once emplace_back succeeded
+        ++m_size;
+    }
+
+    // The value is destroyed, the last one takes its place, but the trie keeps its nodes: after
+    // removing many prefixes, insert what for_each gives into a new table.
+    // returns false if it wasn't there
+    bool erase(const ip_prefix& prefix) noexcept(std::is_nothrow_move_assignable_v<T>)
+    {
+        std::int32_t index = find(prefix);
+        if (index < 0 || m_nodes[index].value < 0)
+            return false;
+        std::int32_t freed = m_nodes[index].value;
+        std::int32_t last = static_cast<std::int32_t>(m_values.size() - 1);
+        m_nodes[index].value = -1;
+        if (freed != last) {
+            m_nodes[find(m_values[last].first)].value = freed;
+            m_values[freed] = std::move(m_values[last]);
+        }
+        m_values.pop_back();
+        --m_size;
+        return true;
+    }
+
+    // the value of the longest prefix containing addr, nullptr if there's none
+    const T* lookup(const address& addr) const noexcept
+    {
+        int family = addr.family();
+        if (family != AF_INET && family != AF_INET6)
+            return nullptr;
+        return lookup(family, detail::make_prefix_key(addr.address_pointer()));
+    }
+
+    // Looks up count addresses, advancing up to batch_width of them a node at a time,
+    // so that the cache misses of different lookups overlap instead of adding up.
+    void lookup(const address* addresses, std::size_t count, const T** results) const noexcept
+    {
+        constexpr std::size_t batch_width = 8;
+        for (std::size_t base = 0; base < count; base += batch_width) {
+            std::size_t width = count - base < batch_width ? count - base : batch_width;
+            detail::prefix_key keys[batch_width];
+            std::int32_t current[batch_width];
+            std::int32_t best[batch_width];
+            unsigned limits[batch_width];
+            std::size_t active = 0;
+
+            for (std::size_t i = 0; i < width; ++i) {
+                const address& addr = addresses[base + i];
+                int family = addr.family();
+                if (family != AF_INET && family != AF_INET6) {
+                    current[i] = -1;
+                    best[i] = -1;
+                    continue;
+                }
+                keys[i] = detail::make_prefix_key(addr.address_pointer());
+                current[i] = family == AF_INET ? 0 : 1;
+                limits[i] = family == AF_INET ? 32 : 128;
+                best[i] = m_nodes[current[i]].value;
+                ++active;
+            }
+
+            while (active) {
+                for (std::size_t i = 0; i < width; ++i) {
+                    if (current[i] < 0)
+                        continue;
+                    std::int32_t next = step(current[i], keys[i], limits[i]);
+                    if (next < 0) {
+                        current[i] = -1;
+                        --active;
+                        continue;
+                    }
+                    if (m_nodes[next].value >= 0)
+                        best[i] = m_nodes[next].value;
+                    current[i] = next;
+#if defined(__GNUC__) || defined(__clang__)
+                    if (m_nodes[next].length < limits[i]) {
+                        std::int32_t ahead = m_nodes[next].children[detail::bit_at(keys[i], m_nodes[next].length)];
+                        if (ahead >= 0)
+                            __builtin_prefetch(&m_nodes[ahead]);
+                    }
+#endif
+                }
+            }
+
+            for (std::size_t i = 0; i < width; ++i)
+                results[base + i] = best[i] >= 0 ? &m_values[best[i]].second : nullptr;
+        }
+    }
+
+    // the prefixes and their values, in the order their trie nodes were created (a prefix that
+    // reuses a branch node comes at that node's place), skipping the erased ones
+    template <typename F>
+    void for_each(F f) const
+    {
+        for (std::size_t node = 0; node < m_nodes.size(); ++node) {
+            std::int32_t value = m_nodes[node].value;
+            if (value >= 0)
+                f(m_values[value].first, m_values[value].second);
+        }
+    }
+
+    std::size_t size() const noexcept
+    {
+        return m_size;
+    }
+
+    bool empty() const noexcept
+    {
+        return m_size == 0;
+    }
+
+    std::size_t node_count() const noexcept
+    {
+        return m_nodes.size();
+    }
+
+private:
+    struct node {
+        detail::prefix_key key;
+        unsigned length;
+        std::int32_t children[2];
+        std::int32_t value; // index in m_values, -1 if it's only a branch
+    };
+
+    // the child of current on the way to key, if it matches key
+    std::int32_t step(std::int32_t current, const detail::prefix_key& key, unsigned limit) const noexcept
+    {
+        const node& n = m_nodes[current];
+        if (n.length >= limit)
+            return -1;
+        std::int32_t child = n.children[detail::bit_at(key, n.length)];
+        if (child < 0 || !detail::prefix_matches(m_nodes[child].key, key, m_nodes[child].length))
+            return -1;
+        return child;
+    }
+
+    const T* lookup(int family, const detail::prefix_key& key) const noexcept
+    {
+        unsigned limit = family == AF_INET ? 32 : 128;
+        std::int32_t current = family == AF_INET ? 0 : 1;
+        std::int32_t best = m_nodes[current].value;
+        while ((current = step(current, key, limit)) >= 0) {
+            if (m_nodes[current].value >= 0)
+                best = m_nodes[current].value;
+        }
+        return best >= 0 ? &m_values[best].second : nullptr;
+    }
+
+    std::int32_t find(const ip_prefix& prefix) const noexcept
+    {
+        if (prefix.family() != AF_INET && prefix.family() != AF_INET6)
+            return -1;
+        detail::prefix_key key = detail::make_prefix_key(prefix);
+        std::int32_t current = prefix.family() == AF_INET ? 0 : 1;
+        while (m_nodes[current].length < prefix.length()) {
+            std::int32_t child = m_nodes[current].children[detail::bit_at(key, m_nodes[current].length)];
+            if (child < 0 || m_nodes[child].length > prefix.length() || !detail::prefix_matches(m_nodes[child].key, key, m_nodes[child].length))
+                return -1;
+            current = child;
+        }
+        return m_nodes[current].length == prefix.length() ? current : -1;
+    }
+
+    // the value slot of the node of prefix, adding the node (and a branch node) if needed
+    std::int32_t& find_or_add(const ip_prefix& prefix)
+    {
+        if (prefix.family() != AF_INET && prefix.family() != AF_INET6)
+            throw std::invalid_argument("prefix tables only hold IP prefixes");
+        detail::prefix_key key = detail::make_prefix_key(prefix);
+        unsigned length = prefix.length();
+        std::int32_t current = prefix.family() == AF_INET ? 0 : 1;
+
+        for (;;) {
+            if (m_nodes[current].length == length)
+                return m_nodes[current].value;
+
+            unsigned bit = detail::bit_at(key, m_nodes[current].length);
+            std::int32_t child = m_nodes[current].children[bit];
+            if (child < 0) {
+                std::int32_t leaf = add_node(key, length);
+                m_nodes[current].children[bit] = leaf;
+                return m_nodes[leaf].value;
+            }
+
+            unsigned child_length = m_nodes[child].length;
+            unsigned common = detail::common_length(m_nodes[child].key, key);
+            if (common >= child_length && child_length <= length) {
+                current = child; // on the path
+                continue;
+            }
+
+            if (common >= length) {
+                // the new prefix goes between current and child
+                std::int32_t middle = add_node(key, length);
+                m_nodes[middle].children[detail::bit_at(m_nodes[child].key, length)] = child;
+                m_nodes[current].children[bit] = middle;
+                return m_nodes[middle].value;
+            }
+
+            // they diverge before either ends, a branch node takes the common part
+            std::int32_t branch = add_node(key, common);
+            std::int32_t leaf = add_node(key, length);
+            m_nodes[branch].children[detail::bit_at(m_nodes[child].key, common)] = child;
+            m_nodes[branch].children[detail::bit_at(key, common)] = leaf;
+            m_nodes[current].children[bit] = branch;
+            return m_nodes[leaf].value;
+        }
+    }
+
+    std::int32_t add_node(const detail::prefix_key& key, unsigned length)
+    {
+        detail::prefix_key masked = key;
+        if (length < 64) {
+            masked.high = length == 0 ? 0 : key.high & (~std::uint64_t {} << (64 - length));
+            masked.low = 0;
+        } else if (length < 128) {
+            masked.low = length == 64 ? 0 : key.low & (~std::uint64_t {} << (128 - length));
+        }
+        m_nodes.push_back({ masked, length, { -1, -1 }, -1 });
+        return static_cast<std::int32_t>(m_nodes.size() - 1);
+    }
+
+    std::vector<node> m_nodes;
+    std::vector<std::pair<ip_prefix, T>> m_values;
+    std::size_t m_size = 0;
+};
+
+// Publishes prefix tables to readers on other threads: readers load() a snapshot, which stays
+// valid while they hold it, and a writer builds a new table aside and store()s it.
+template <typename T>
+class atomic_prefix_table {
+public:
+    using table = prefix_table<T>;
+
+    atomic_prefix_table()
+        : m_table { std::make_shared<const table>() }
+    {
+    }
+
+    explicit atomic_prefix_table(table initial)
+        : m_table { std::make_shared<const table>(std::move(initial)) }
+    {
+    }
+
+    std::shared_ptr<const table> load() const noexcept
+    {
+        return std::atomic_load(&m_table);
+    }
+
+    void store(table updated)
+    {
+        std::atomic_store(&m_table, std::shared_ptr<const table>(std::make_shared<const table>(std::move(updated))));
+    }
+
+    std::shared_ptr<const table> exchange(table updated)
+    {
+        return std::atomic_exchange(&m_table, std::shared_ptr<const table>(std::make_shared<const table>(std::move(updated))));
+    }
+
+private:
+    std::shared_ptr<const table> m_table;
+};
+
+} // namespace net
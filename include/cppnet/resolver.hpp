@@ -0,0 +1,167 @@
+#pragma once
+#ifndef __linux__
+#error the asynchronous resolver is only avilable in linux
+#endif
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <cppnet/address.hpp>
+#include <cppnet/epoll.hpp>
+#include <cppnet/getaddrinfo.hpp>
+#include <cppnet/socket.hpp>
+
+// Non-blocking name resolution, speaking DNS over UDP (and TCP for truncated answers) itself
+// instead of blocking a thread in ::getaddrinfo.
+//
+//     net::resolver resolver;
+//     loop.add(resolver.native_handle(), net::epoll::read);
+//     resolver.resolve("example.com", 443, AF_UNSPEC, SOCK_STREAM, 0, 0, [](std::error_code e, std::vector<net::address_info> results) { ... });
+//     on read events of resolver.native_handle(), and once resolver.remaining() elapsed: resolver.process()
+//
+// Its handle is an epoll instance, so any poller (net::epoll, net::poll, net::select) can wait on it.
+
+namespace net {
+
+struct resolver_config {
+    std::vector<address> nameservers; // tried in order, port 53 unless stated otherwise
+    std::vector<std::string> search; // domains appended to names with less than ndots dots
+    unsigned ndots = 1;
+    std::chrono::milliseconds timeout = std::chrono::seconds(5); // per transmission
+    unsigned attempts = 2; // rounds over the nameservers
+    bool edns0 = false; // advertise 1232 byte UDP answers, fewer fall back to TCP
+
+    // Parses nameserver, domain, search and options (ndots, timeout, attempts, edns0) like glibc.
+    // Without nameservers, 127.0.0.1 is used, without search or domain, the domain of the host name.
+    static resolver_config from_resolv_conf(const char* path = "/etc/resolv.conf");
+};
+
+class resolver {
+public:
+    using clock = std::chrono::steady_clock;
+    using native_handle_type = epoll::native_handle_type;
+    using query_id = std::uint64_t;
+
+    // Receives the results in the order getaddrinfo would give them (IPv6 first), or an error of
+    // addrinfo_category(): EAI_NONAME when the name doesn't exist or has no addresses of the family,
+    // EAI_AGAIN when the nameservers timed out or failed, EAI_FAIL for malformed answers.
+    using callback = std::function<void(std::error_code, std::vector<address_info>)>;
+
+    // reads /etc/resolv.conf and /etc/hosts
+    resolver();
+    explicit resolver(resolver_config config, const char* hosts_path = "/etc/hosts");
+
+    resolver(const resolver&) = delete;
+    resolver& operator=(const resolver&) = delete;
+
+    // Starts resolving host, as getaddrinfo(host, port, {family, type, protocol, flags}) would.
+    // AI_CANONNAME and AI_NUMERICHOST are honored. Numeric hosts, names found in the hosts file and
+    // localhost (RFC 6761, the loopback addresses when the hosts file doesn't name it) complete right
+    // away, the callback is then called before resolve returns.
+    query_id resolve(std::string_view host, std::uint16_t port, int family, int type, int protocol, int flags, callback done);
+
+    // the callback won't be called
+    void cancel(query_id id) noexcept;
+
+    // to be registered for read in the event loop
+    native_handle_type native_handle() const noexcept
+    {
+        return m_poller.native_handle();
+    }
+
+    // Reads the answers that arrived, retransmits the queries that timed out and calls the callbacks
+    // of the lookups that finished.
+    void process();
+    void process(std::error_code&);
+
+    // time until the next retransmission is due, to bound the poller timeout, nullopt when idle
+    std::optional<std::chrono::milliseconds> remaining() const noexcept;
+
+    // lookups in progress
+    std::size_t pending() const noexcept
+    {
+        return m_lookups.size();
+    }
+
+    const resolver_config& config() const noexcept
+    {
+        return m_config;
+    }
+
+private:
+    enum class outcome {
+        pending,
+        answered,
+        no_name, // NXDOMAIN, or no records of the type
+        again, // timed out, SERVFAIL, REFUSED
+        fail, // FORMERR or malformed
+    };
+
+    struct host_entry {
+        std::string canon_name;
+        address addr; // port 0
+    };
+
+    struct lookup {
+        std::vector<std::string> names; // candidates, with the search domains applied
+        std::size_t name = 0; // the one being queried
+        std::uint16_t port;
+        int family;
+        int type;
+        int protocol;
+        int flags;
+        callback done;
+        std::vector<std::pair<std::uint16_t, outcome>> queries; // message id, 0 when not sent
+        std::vector<address> addresses;
+        std::string canon_name;
+    };
+
+    struct transaction {
+        query_id owner;
+        std::uint16_t qtype;
+        std::vector<unsigned char> query;
+        unsigned transmissions = 0;
+        clock::time_point deadline;
+        // TCP fallback, when the UDP answer was truncated
+        socket tcp;
+        std::vector<unsigned char> tcp_buffer;
+        std::size_t tcp_offset = 0;
+        bool tcp_writing = false;
+    };
+
+    void load_hosts(const char* path);
+    bool resolve_locally(lookup& l, std::string_view host);
+    void start_name(query_id id, lookup& l);
+    bool transmit(std::uint16_t id, transaction& t) noexcept;
+    void start_tcp(std::uint16_t id, transaction& t, std::size_t server);
+    void read_udp(socket& sock);
+    void handle_tcp(socket::native_handle_type fd, std::uint32_t events);
+    void handle_answer(std::uint16_t id, const unsigned char* message, std::size_t size, bool tcp);
+    void finish_transaction(std::uint16_t id, outcome result);
+    void settle(query_id id, lookup& l);
+    void deliver();
+    void stop_tcp(transaction& t) noexcept;
+
+    resolver_config m_config;
+    std::unordered_multimap<std::string, host_entry> m_hosts; // by lowercase name
+    epoll m_poller;
+    std::vector<socket> m_udp; // one connected socket per nameserver
+    std::unordered_map<query_id, lookup> m_lookups;
+    std::unordered_map<std::uint16_t, transaction> m_transactions; // by DNS message id
+    std::unordered_map<socket::native_handle_type, std::uint16_t> m_tcp; // fd to message id
+    std::vector<std::pair<query_id, std::error_code>> m_finished;
+    query_id m_next_id = 1;
+    std::mt19937 m_random;
+};
+
+} // namespace net
@@ -0,0 +1,43 @@
+#pragma once
+#ifndef __linux__
+#error SO_REUSEPORT steering is only avilable in linux
+#endif
+
+#include <system_error>
+#include <vector>
+
+#include <cppnet/address.hpp>
+#include <cppnet/bpf.hpp>
+#include <cppnet/socket.hpp>
+
+// CPU affine SO_REUSEPORT groups
+//
+// One listener per loop thread, listener i is accepted from by the thread pinned to CPU i,
+// and the kernel hands each new connection to the listener of the CPU that received its packets.
+// The softirq, the accept and the rest of the connection then stay on one core.
+// Pair it with RSS/RPS (or XPS) so that the flows are spread over the CPUs to begin with.
+
+namespace net {
+
+// returns cpu % listeners, the full locality is only achieved with one listener per CPU
+bpf_program reuseport_cpu_program(unsigned listeners);
+
+void attach_reuseport_cpu_steering(socket& sock, unsigned listeners);
+void attach_reuseport_cpu_steering(socket& sock, unsigned listeners, std::error_code&) noexcept;
+
+// Creates count listeners bound to addr with SO_REUSEPORT, in group order, and attaches
+// the CPU steering program. For SOCK_DGRAM nothing is listened on, the group steers datagrams.
+std::vector<socket> reuseport_listeners(const address& addr, unsigned count, int backlog, int type = SOCK_STREAM);
+std::vector<socket> reuseport_listeners(const address& addr, unsigned count, int backlog, int type, std::error_code&);
+
+// online CPUs, packets may be received by any of them regardless of the affinity of this process
+unsigned cpu_count() noexcept;
+
+// CPU the calling thread is running on right now
+unsigned current_cpu() noexcept;
+
+// restricts the calling thread to the given CPU
+void pin_thread_to_cpu(unsigned cpu);
+void pin_thread_to_cpu(unsigned cpu, std::error_code&) noexcept;
+
+} // namespace net
@@ -62,6 +62,18 @@ public:
         return it;
     }
 
+    // registered file descriptors
+
+    template <typename OIt>
+    OIt handles(OIt it) const noexcept(noexcept(*it = socket::native_handle_type {}) && noexcept(++it))
+    {
+        for (const auto& item : fdlist) {
+            *it = item.fd;
+            ++it;
+        }
+        return it;
+    }
+
 private:
     struct selectfd {
         socket::native_handle_type fd;
@@ -14,6 +14,7 @@
 #endif
 
 #include <cppnet/address.hpp>
+#include <cppnet/endpoint.hpp>
 
 #if __cplusplus >= 202002L
 #include <version>
@@ -44,8 +45,10 @@ public:
 
     constexpr socket& operator=(socket&& rhs) noexcept
     {
+        // the previous handle goes to rhs, which closes it when destroyed
+        native_handle_type handle = m_handle;
         m_handle = rhs.m_handle;
-        rhs.m_handle = invalid_handle;
+        rhs.m_handle = handle;
         return *this;
     }
 
@@ -110,6 +113,52 @@ public:
         return sendto(buffer, buffer_size, flags, reinterpret_cast<sockaddr const*>(&addr.m_socket_address), addr.m_socket_address_size, e);
     }
 
+    // the compact endpoints, without a sockaddr_storage
+    size_t sendto(const void* buffer, size_t buffer_size, int flags, const endpoint_v4& endpoint)
+    {
+        sockaddr_in addr = endpoint.native();
+        return sendto(buffer, buffer_size, flags, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr));
+    }
+
+    size_t sendto(const void* buffer, size_t buffer_size, int flags, const endpoint_v4& endpoint, std::error_code& e) noexcept
+    {
+        sockaddr_in addr = endpoint.native();
+        return sendto(buffer, buffer_size, flags, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr), e);
+    }
+
+    size_t sendto(const void* buffer, size_t buffer_size, int flags, const endpoint_v6& endpoint)
+    {
+        sockaddr_in6 addr = endpoint.native();
+        return sendto(buffer, buffer_size, flags, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr));
+    }
+
+    size_t sendto(const void* buffer, size_t buffer_size, int flags, const endpoint_v6& endpoint, std::error_code& e) noexcept
+    {
+        sockaddr_in6 addr = endpoint.native();
+        return sendto(buffer, buffer_size, flags, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr), e);
+    }
+
+#ifndef _WIN32
+    size_t recvmsg(msghdr* message, int flags);
+    size_t recvmsg(msghdr* message, int flags, std::error_code&) noexcept;
+
+    size_t sendmsg(const msghdr* message, int flags);
+    size_t sendmsg(const msghdr* message, int flags, std::error_code&) noexcept;
+
+    // SCM_RIGHTS, AF_UNIX only. Up to max_fds (253 in linux) descriptors go along with the data,
+    // which must be at least one byte long. The sent descriptors remain open in this process.
+    static constexpr size_t max_fds = 253;
+
+    size_t send_fds(const native_handle_type* handles, size_t count, const void* buffer, size_t buffer_size, int flags = 0);
+    size_t send_fds(const native_handle_type* handles, size_t count, const void* buffer, size_t buffer_size, int flags, std::error_code&) noexcept;
+
+    // Stores the received descriptors in sockets and their count in received.
+    // If more than max_sockets were sent the rest are closed, and it fails with std::errc::message_size
+    // after storing the ones that fit.
+    size_t recv_fds(void* buffer, size_t buffer_size, socket* sockets, size_t max_sockets, size_t* received, int flags = 0);
+    size_t recv_fds(void* buffer, size_t buffer_size, socket* sockets, size_t max_sockets, size_t* received, int flags, std::error_code&) noexcept;
+#endif
+
     void connect(const sockaddr* address, size_t address_size);
     void connect(const sockaddr* address, size_t address_size, std::error_code&) noexcept;
 
@@ -123,6 +172,30 @@ public:
         connect(reinterpret_cast<const sockaddr*>(&addr.m_socket_address), addr.m_socket_address_size, e);
     }
 
+    void connect(const endpoint_v4& endpoint)
+    {
+        sockaddr_in addr = endpoint.native();
+        connect(reinterpret_cast<const sockaddr*>(&addr), sizeof(addr));
+    }
+
+    void connect(const endpoint_v4& endpoint, std::error_code& e) noexcept
+    {
+        sockaddr_in addr = endpoint.native();
+        connect(reinterpret_cast<const sockaddr*>(&addr), sizeof(addr), e);
+    }
+
+    void connect(const endpoint_v6& endpoint)
+    {
+        sockaddr_in6 addr = endpoint.native();
+        connect(reinterpret_cast<const sockaddr*>(&addr), sizeof(addr));
+    }
+
+    void connect(const endpoint_v6& endpoint, std::error_code& e) noexcept
+    {
+        sockaddr_in6 addr = endpoint.native();
+        connect(reinterpret_cast<const sockaddr*>(&addr), sizeof(addr), e);
+    }
+
     socket accept(sockaddr* address, size_t* address_size);
     socket accept(sockaddr* address, size_t* address_size, std::error_code&) noexcept;
 
@@ -244,7 +317,10 @@ public:
 
     std::error_code error() const noexcept
     {
-        auto error_number = getsockopt<int>(SOL_SOCKET, SO_ERROR);
+        std::error_code e;
+        auto error_number = getsockopt<int>(SOL_SOCKET, SO_ERROR, e);
+        if (e)
+            return e;
         return std::error_code { error_number, std::system_category() };
     }
 
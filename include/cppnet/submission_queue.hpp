@@ -0,0 +1,200 @@
+#pragma once
+#ifndef __linux__
+#error the submission queue is only avilable in linux
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+namespace net {
+
+// A non blocking eventfd, to wake up an event loop from other threads
+class doorbell {
+public:
+    doorbell();
+    explicit doorbell(std::error_code&) noexcept;
+
+    doorbell(const doorbell&) = delete;
+    doorbell& operator=(const doorbell&) = delete;
+
+    ~doorbell() noexcept;
+
+    using native_handle_type = int;
+
+    // readable once rung, until reset
+    native_handle_type native_handle() const noexcept
+    {
+        return m_handle;
+    }
+
+    void ring() noexcept;
+
+    void reset() noexcept;
+
+private:
+    native_handle_type m_handle = -1;
+};
+
+// A lock free queue from any number of threads to the thread running an event loop, with a
+// doorbell the loop polls along with its sockets:
+//
+//     net::submission_queue<job> jobs;
+//     poller.add(jobs.native_handle(), net::epoll::read);
+//     for (;;) {
+//         poller.execute(jobs.prepare_wait(std::nullopt));
+//         jobs.finish_wait();
+//         jobs.drain([](job&& j) { ... });
+//         ... the sockets' events
+//     }
+//
+// The doorbell is only rung when the loop is about to block, or blocked, in the poller: the
+// submissions made while it's busy are found by its next drain() without any system call, and a
+// burst of them while it's asleep wakes it up once.
+//
+// Pushes take one atomic exchange and one allocation, there's no mutex.
+template <typename T>
+class submission_queue {
+public:
+    submission_queue()
+        : m_head { &m_stub }
+        , m_tail { &m_stub }
+    {
+    }
+
+    explicit submission_queue(std::error_code& e) noexcept
+        : m_doorbell { e }
+        , m_head { &m_stub }
+        , m_tail { &m_stub }
+    {
+    }
+
+    submission_queue(const submission_queue&) = delete;
+    submission_queue& operator=(const submission_queue&) = delete;
+
+    ~submission_queue() noexcept
+    {
+        while (pop())
+            ;
+        if (m_tail != &m_stub)
+            delete m_tail;
+    }
+
+    doorbell::native_handle_type native_handle() const noexcept
+    {
+        return m_doorbell.native_handle();
+    }
+
+    // From any thread
+    template <typename... Args>
+    void emplace(Args&&... args)
+    {
+        node* n = new node { std::in_place, std::forward<Args>(args)... };
+        node* previous = m_head.exchange(n);
+        previous->next.store(n);
+        // the loop set m_sleeping before it last looked at m_head, or it will see n
+        if (m_sleeping.load() && m_sleeping.exchange(false)) {
+            m_doorbell.ring();
+            m_rung.store(true, std::memory_order_release);
+            m_wakeups.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void push(T value)
+    {
+        emplace(std::move(value));
+    }
+
+    // The rest is for the loop's thread only
+
+    // Before blocking in the poller, returns the timeout to block with: zero when there are
+    // submissions already, timeout otherwise
+    std::optional<std::chrono::milliseconds> prepare_wait(std::optional<std::chrono::milliseconds> timeout) noexcept
+    {
+        m_sleeping.store(true);
+        if (m_head.load() != m_tail) {
+            m_sleeping.store(false, std::memory_order_relaxed);
+            return std::chrono::milliseconds::zero();
+        }
+        return timeout;
+    }
+
+    // After the poller returned, whatever it returned
+    void finish_wait() noexcept
+    {
+        m_sleeping.store(false, std::memory_order_relaxed);
+        if (m_rung.exchange(false, std::memory_order_acquire))
+            m_doorbell.reset();
+    }
+
+    // The oldest submission, if there's any complete one
+    std::optional<T> pop() noexcept(std::is_nothrow_move_constructible_v<T>)
+    {
+        node* next = m_tail->next.load(std::memory_order_acquire);
+        if (!next)
+            return std::nullopt;
+        std::optional<T> value { std::move(*next->value) };
+        next->value.reset();
+        node* consumed = std::exchange(m_tail, next);
+        if (consumed != &m_stub)
+            delete consumed;
+        else
+            m_stub.next.store(nullptr, std::memory_order_relaxed);
+        return value;
+    }
+
+    // Calls f(T&&) with up to max submissions, in order, returns how many
+    template <typename F>
+    std::size_t drain(F&& f, std::size_t max = static_cast<std::size_t>(-1))
+    {
+        std::size_t count = 0;
+        for (; count < max; ++count) {
+            std::optional<T> value = pop();
+            if (!value)
+                break;
+            f(std::move(*value));
+        }
+        return count;
+    }
+
+    // whether everything pushed was popped, a push in progress counts
+    bool empty() const noexcept
+    {
+        return m_head.load(std::memory_order_acquire) == m_tail;
+    }
+
+    // how many times the doorbell was rung
+    std::uint64_t wakeups() const noexcept
+    {
+        return m_wakeups.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct node {
+        template <typename... Args>
+        explicit node(std::in_place_t, Args&&... args)
+            : value { std::in_place, std::forward<Args>(args)... }
+        {
+        }
+
+        node() noexcept = default;
+
+        std::atomic<node*> next { nullptr };
+        std::optional<T> value;
+    };
+
+    doorbell m_doorbell;
+    node m_stub; // the tail when nothing was pushed yet
+    alignas(64) std::atomic<node*> m_head; // the last pushed, producers' side
+    alignas(64) node* m_tail; // the last popped, the loop's side
+    std::atomic<bool> m_sleeping { false };
+    std::atomic<bool> m_rung { false };
+    std::atomic<std::uint64_t> m_wakeups { 0 };
+};
+
+} // namespace net
@@ -0,0 +1,113 @@
+#pragma once
+#ifndef __linux__
+#error TCP_INFO is only avilable in linux
+#endif
+
+#include <chrono>
+#include <cstdint>
+#include <iterator>
+#include <system_error>
+#include <vector>
+
+#include <cppnet/socket.hpp>
+
+namespace net {
+
+// A snapshot of the transport state of a TCP connection.
+// Fields the running kernel doesn't report are left as zero.
+struct tcp_stats {
+    std::uint8_t state; // TCP_ESTABLISHED, TCP_CLOSE_WAIT, ...
+    std::uint8_t ca_state; // congestion avoidance state, TCP_CA_Open, TCP_CA_Loss, ...
+
+    std::chrono::microseconds rtt; // smoothed round trip time
+    std::chrono::microseconds rttvar;
+    std::chrono::microseconds min_rtt;
+    std::chrono::microseconds rto;
+
+    std::uint32_t mss;
+    std::uint32_t cwnd; // in segments
+    std::uint32_t ssthresh; // in segments
+
+    std::uint32_t retransmits; // consecutive retransmission timeouts of the current segment
+    std::uint32_t total_retransmits; // retransmitted segments during the whole connection
+    std::uint32_t lost; // segments considered lost right now
+
+    std::uint32_t unacked; // segments in flight
+    std::uint64_t unacked_bytes; // bytes sent at least once that were not acknowledged yet
+    std::uint32_t notsent_bytes; // bytes queued by the application that were not sent yet
+
+    std::uint64_t bytes_acked;
+    std::uint64_t bytes_received;
+    std::uint64_t delivery_rate; // bytes per second, as estimated by the kernel
+};
+
+tcp_stats tcp_info(const socket& sock);
+tcp_stats tcp_info(const socket& sock, std::error_code&) noexcept;
+tcp_stats tcp_info(socket::native_handle_type fd, std::error_code&) noexcept;
+
+// Samples every TCP socket registered in a poller, at most once per interval.
+// Meant to be called on each iteration of the event loop, with remaining() bounding the poller timeout.
+class tcp_info_sampler {
+public:
+    using clock = std::chrono::steady_clock;
+
+    explicit tcp_info_sampler(std::chrono::milliseconds interval) noexcept
+        : m_interval { interval }
+        , m_next { clock::now() }
+    {
+    }
+
+    std::chrono::milliseconds interval() const noexcept
+    {
+        return m_interval;
+    }
+
+    void interval(std::chrono::milliseconds interval) noexcept
+    {
+        m_next += interval - m_interval;
+        m_interval = interval;
+    }
+
+    // time until the next sample is due
+    std::chrono::milliseconds remaining() const noexcept
+    {
+        auto now = clock::now();
+        if (now >= m_next)
+            return std::chrono::milliseconds::zero();
+        return std::chrono::ceil<std::chrono::milliseconds>(m_next - now);
+    }
+
+    // Calls callback(fd, const tcp_stats&) for every socket the poller has that answers TCP_INFO.
+    // Returns the number of sockets sampled, zero if the interval didn't elapse yet.
+    template <typename Poller, typename F>
+    std::size_t sample(const Poller& poller, F&& callback)
+    {
+        auto now = clock::now();
+        if (now < m_next)
+            return 0;
+        m_next += m_interval;
+        if (m_next < now) // we fell behind, don't try to catch up
+            m_next = now + m_interval;
+
+        m_handles.clear();
+        poller.handles(std::back_inserter(m_handles));
+
+        std::size_t sampled = 0;
+        for (socket::native_handle_type fd : m_handles) {
+            std::error_code e;
+            tcp_stats stats = tcp_info(fd, e);
+            if (e) // not a TCP socket, or already closed
+                continue;
+            callback(fd, static_cast<const tcp_stats&>(stats));
+            ++sampled;
+        }
+        return sampled;
+    }
+
+private:
+    std::chrono::milliseconds m_interval;
+    clock::time_point m_next;
+    std::vector<socket::native_handle_type> m_handles;
+};
+
+} // namespace net
@@ -0,0 +1,119 @@
+#pragma once
+#ifndef __linux__
+#error packet timestamping is only avilable in linux
+#endif
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <system_error>
+
+#include <linux/net_tstamp.h>
+
+#include <cppnet/address.hpp>
+#include <cppnet/socket.hpp>
+
+namespace net {
+
+enum timestamping : unsigned {
+    // where timestamps are generated
+
+    rx_software = SOF_TIMESTAMPING_RX_SOFTWARE, // When the packet enters the kernel stack
+    rx_hardware = SOF_TIMESTAMPING_RX_HARDWARE, // By the network adapter, needs driver support
+    tx_scheduled = SOF_TIMESTAMPING_TX_SCHED, // Before entering the packet scheduler (qdisc)
+    tx_software = SOF_TIMESTAMPING_TX_SOFTWARE, // When the packet is handed to the driver
+    tx_hardware = SOF_TIMESTAMPING_TX_HARDWARE, // By the network adapter, needs driver support
+    tx_acknowledged = SOF_TIMESTAMPING_TX_ACK, // When all the bytes of a send were acknowledged, TCP only
+
+    // which timestamps are reported
+
+    software = SOF_TIMESTAMPING_SOFTWARE,
+    raw_hardware = SOF_TIMESTAMPING_RAW_HARDWARE,
+
+    // options
+
+    opt_id = SOF_TIMESTAMPING_OPT_ID, // Tag transmit timestamps with a key, see tx_timestamp_tracker
+    opt_tsonly = SOF_TIMESTAMPING_OPT_TSONLY, // Don't loop the packet back with transmit timestamps
+
+    // everything that can be generated without hardware support, works on loopback
+    all_software = rx_software | tx_scheduled | tx_software | tx_acknowledged | software | opt_id | opt_tsonly,
+};
+
+struct packet_timestamp {
+    enum kinds {
+        received,
+        scheduled, // SCM_TSTAMP_SCHED
+        sent, // SCM_TSTAMP_SND
+        acknowledged, // SCM_TSTAMP_ACK
+    };
+
+    kinds kind = received;
+    std::uint32_t key = 0; // only for transmit timestamps with opt_id
+    std::chrono::nanoseconds software {}; // CLOCK_REALTIME since the epoch, zero if not reported
+    std::chrono::nanoseconds hardware {}; // raw adapter clock, zero if not reported
+};
+
+// For stream sockets enable it after connecting, the opt_id keys are counted from that point.
+void enable_timestamping(socket& sock, unsigned flags = all_software);
+void enable_timestamping(socket& sock, unsigned flags, std::error_code&) noexcept;
+
+// SO_TIMESTAMPNS, receive timestamps only
+void enable_receive_timestamps(socket& sock);
+void enable_receive_timestamps(socket& sock, std::error_code&) noexcept;
+
+// recvfrom(2) that also extracts the receive timestamp from the control messages
+size_t recv_timestamped(socket& sock, void* buffer, size_t buffer_size, int flags, packet_timestamp& timestamp, address* from = nullptr);
+size_t recv_timestamped(socket& sock, void* buffer, size_t buffer_size, int flags, packet_timestamp& timestamp, address* from, std::error_code&) noexcept;
+
+// Reads one transmit timestamp from the error queue without blocking.
+// Returns false when the queue is empty, in which case no error is reported.
+bool recv_tx_timestamp(socket& sock, packet_timestamp& timestamp);
+bool recv_tx_timestamp(socket& sock, packet_timestamp& timestamp, std::error_code&) noexcept;
+
+// Pairs transmit timestamps with the sends they belong to.
+// Requires opt_id, and every send made on the socket must be recorded in order.
+class tx_timestamp_tracker {
+public:
+    struct record {
+        std::uint32_t key;
+        std::uint64_t first_byte; // offset in the stream, or index of the datagram
+        std::size_t size;
+        std::chrono::nanoseconds submitted; // CLOCK_REALTIME since the epoch, when the application sent it
+        std::chrono::nanoseconds scheduled {};
+        std::chrono::nanoseconds sent {};
+        std::chrono::nanoseconds acknowledged {};
+    };
+
+    // completion is the last timestamp expected for each send, see pop()
+    explicit tx_timestamp_tracker(bool stream, packet_timestamp::kinds completion = packet_timestamp::sent) noexcept
+        : m_stream { stream }
+        , m_completion { completion }
+    {
+    }
+
+    // bytes is what send() returned, submitted defaults to the time of the call
+    // so take it before sending if the kernel queuing delay is going to be measured
+    const record& on_send(std::size_t bytes);
+    const record& on_send(std::size_t bytes, std::chrono::nanoseconds submitted);
+
+    // returns the updated record, or nullptr if the key doesn't belong to a pending send
+    const record* on_timestamp(const packet_timestamp& timestamp) noexcept;
+
+    // removes the oldest send once it got its completion timestamp
+    std::optional<record> pop();
+
+    std::size_t pending() const noexcept
+    {
+        return m_pending.size();
+    }
+
+private:
+    bool m_stream;
+    packet_timestamp::kinds m_completion;
+    std::uint64_t m_next_byte = 0;
+    std::uint32_t m_next_key = 0;
+    std::deque<record> m_pending;
+};
+
+} // namespace net
@@ -0,0 +1,153 @@
+#pragma once
+#ifndef CPPNET_WITH_OPENSSL
+#error the TLS layer is only avilable when cppnet is built with CPPNET_WITH_OPENSSL
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#include <cppnet/socket.hpp>
+
+struct ssl_st;
+struct ssl_ctx_st;
+
+// TLS 1.2 and 1.3 streams over net::socket, with OpenSSL 3.
+//
+// The handshake is done by OpenSSL, which then hands the session keys to the kernel
+// (setsockopt(SOL_TLS, TLS_TX/TLS_RX), kernel TLS) when it can: in linux with the tls module, for
+// AES-GCM and ChaCha20-Poly1305. The kernel then encrypts what is sent, so that files can be sent
+// with sendfile without being copied to user space. When it can't, records are encrypted and
+// decrypted by OpenSSL, transparently. OpenSSL 3.0 offloads receiving for TLS 1.2 only.
+
+namespace net::tls {
+
+// OpenSSL's ERR_get_error() codes
+const std::error_category& category() noexcept;
+
+class context {
+public:
+    enum class role {
+        client,
+        server,
+    };
+
+    // TLS 1.2 at least, with kernel TLS enabled. Clients verify the server's certificate with
+    // the system's certificate authorities
+    explicit context(role r);
+
+    context(const context&) = delete;
+    context& operator=(const context&) = delete;
+
+    ~context() noexcept;
+
+    // PEM files
+    void use_certificate_chain_file(const std::string& path);
+    void use_certificate_chain_file(const std::string& path, std::error_code&) noexcept;
+
+    void use_private_key_file(const std::string& path);
+    void use_private_key_file(const std::string& path, std::error_code&) noexcept;
+
+    void load_verify_file(const std::string& path);
+    void load_verify_file(const std::string& path, std::error_code&) noexcept;
+
+    // whether the peer's certificate is required and verified
+    void verify_peer(bool enabled) noexcept;
+
+    role side() const noexcept
+    {
+        return m_role;
+    }
+
+    ssl_ctx_st* native_handle() noexcept
+    {
+        return m_ctx;
+    }
+
+private:
+    ssl_ctx_st* m_ctx = nullptr;
+    role m_role;
+};
+
+// A TLS connection on a connected socket, which it owns. The context must outlive it.
+//
+// Non blocking sockets are supported: operations that would block fail with
+// std::errc::operation_would_block and are retried with the same arguments once the socket
+// is readable or writable.
+class stream {
+public:
+    stream(context& ctx, socket sock);
+
+    stream(stream&& rhs) noexcept;
+    stream& operator=(stream&& rhs) noexcept;
+
+    stream(const stream&) = delete;
+    stream& operator=(const stream&) = delete;
+
+    ~stream() noexcept;
+
+    // for clients, the name sent with SNI, and that the server's certificate must be valid for
+    void set_server_name(const std::string& name);
+    void set_server_name(const std::string& name, std::error_code&) noexcept;
+
+    void handshake();
+    void handshake(std::error_code&) noexcept;
+
+    // Returns how much of buffer was sent, some of it at least
+    std::size_t send(const void* buffer, std::size_t size);
+    std::size_t send(const void* buffer, std::size_t size, std::error_code&) noexcept;
+
+    std::size_t send(std::string_view buffer)
+    {
+        return send(buffer.data(), buffer.size());
+    }
+
+    std::size_t send(std::string_view buffer, std::error_code& e) noexcept
+    {
+        return send(buffer.data(), buffer.size(), e);
+    }
+
+    // Returns 0 once the peer closed the session
+    std::size_t recv(void* buffer, std::size_t size);
+    std::size_t recv(void* buffer, std::size_t size, std::error_code&) noexcept;
+
+#ifndef _WIN32
+    // Sends size bytes of the file from offset: with the sendfile system call when the kernel
+    // encrypts, by reading it in chunks otherwise. Returns how much was sent.
+    std::size_t sendfile(int fd, std::int64_t offset, std::size_t size);
+    std::size_t sendfile(int fd, std::int64_t offset, std::size_t size, std::error_code&) noexcept;
+#endif
+
+    // sends close_notify
+    void shutdown();
+    void shutdown(std::error_code&) noexcept;
+
+    // whether the kernel encrypts what is sent, after the handshake
+    bool ktls_send() const noexcept;
+
+    // whether the kernel decrypts what is received, after the handshake
+    bool ktls_recv() const noexcept;
+
+    // the negotiated version, as "TLSv1.3"
+    std::string_view version() const noexcept;
+
+    std::string_view cipher() const noexcept;
+
+    net::socket& socket() noexcept
+    {
+        return m_socket;
+    }
+
+    ssl_st* native_handle() noexcept
+    {
+        return m_ssl;
+    }
+
+private:
+    net::socket m_socket;
+    ssl_st* m_ssl = nullptr;
+};
+
+} // namespace net::tls
@@ -0,0 +1,257 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+#include <cppnet/http.hpp>
+#include <cppnet/socket.hpp>
+
+// WebSocket framing, RFC 6455.
+//
+// Frames are parsed in place: payloads are unmasked where they were received and handed out as
+// views of the receive buffer. Masking is done with SSE2, or AVX2 when the CPU has it, on x86-64.
+// Extensions, as permessage-deflate, aren't supported and text messages aren't checked to be UTF-8.
+
+namespace net::websocket {
+
+enum class errc {
+    bad_frame = 1,
+    bad_opcode,
+    bad_control_frame,
+    bad_continuation,
+    bad_masking,
+    message_too_big,
+    bad_handshake,
+};
+
+const std::error_category& category() noexcept;
+
+inline std::error_code make_error_code(errc e) noexcept
+{
+    return { static_cast<int>(e), category() };
+}
+
+enum class opcode : std::uint8_t {
+    continuation = 0x0,
+    text = 0x1,
+    binary = 0x2,
+    close = 0x8,
+    ping = 0x9,
+    pong = 0xa,
+};
+
+// close, ping and pong
+constexpr bool is_control(opcode op) noexcept
+{
+    return static_cast<std::uint8_t>(op) & 0x8;
+}
+
+constexpr std::size_t max_header_size = 14;
+constexpr std::size_t max_control_payload = 125;
+
+using mask_key = std::array<unsigned char, 4>;
+
+struct frame_header {
+    bool fin;
+    opcode op;
+    bool masked;
+    mask_key key; // when masked
+    std::uint64_t length; // of the payload
+};
+
+// Parses the header of the frame at the start of buffer. Returns its size, where the payload
+// starts, or 0 when buffer doesn't hold all of it yet.
+std::size_t parse(std::string_view buffer, frame_header& header);
+std::size_t parse(std::string_view buffer, frame_header& header, std::error_code&) noexcept;
+
+// XORs size bytes with key, as the bytes at offset in a payload. It's its own inverse
+void mask(void* data, std::size_t size, mask_key key, std::size_t offset = 0) noexcept;
+
+// Writes a frame header to out, which has room for max_header_size bytes, and returns its size.
+// Frames are masked with key when there's one, as clients must send them.
+std::size_t encode_header(char* out, opcode op, std::uint64_t length, bool fin = true, const mask_key* key = nullptr) noexcept;
+
+// Appends a whole frame, a masked one has its payload masked as it's copied
+void append_frame(std::string& out, opcode op, std::string_view payload, bool fin = true);
+void append_frame(std::string& out, opcode op, std::string_view payload, mask_key key, bool fin = true);
+
+// The Sec-WebSocket-Key of an opening handshake, after checking the request is one
+std::string_view upgrade_key(const http::request& req);
+std::string_view upgrade_key(const http::request& req, std::error_code&) noexcept;
+
+// base64(SHA-1(key + the RFC 6455 GUID)), the Sec-WebSocket-Accept answering key
+std::string accept_key(std::string_view key);
+
+// Appends the 101 response accepting the handshake that sent key
+void append_handshake_response(std::string& out, std::string_view key);
+
+// Keeps cleared buffers around, for the messages that come in fragments. It's safe to use from
+// multiple threads.
+class buffer_pool {
+public:
+    // buffers that grew beyond max_capacity are freed instead of being kept
+    explicit buffer_pool(std::size_t max_buffers = 64, std::size_t max_capacity = 1024 * 1024) noexcept
+        : m_max_buffers { max_buffers }
+        , m_max_capacity { max_capacity }
+    {
+    }
+
+    buffer_pool(const buffer_pool&) = delete;
+    buffer_pool& operator=(const buffer_pool&) = delete;
+
+    // an empty buffer, with the capacity it had when it was released
+    std::vector<char> acquire();
+
+    void release(std::vector<char>&& buffer) noexcept;
+
+    std::size_t size() const noexcept;
+
+private:
+    mutable std::mutex m_mutex;
+    std::vector<std::vector<char>> m_buffers;
+    std::size_t m_max_buffers;
+    std::size_t m_max_capacity;
+};
+
+struct message {
+    opcode type; // text, binary or a control frame's
+    std::string_view data;
+};
+
+// Reassembles the messages of a connection from its frames:
+//
+//     std::size_t used = assembler.feed(buffer + begin, end - begin, e);
+//     begin += used;
+//     if (assembler.ready())
+//         on_message(assembler.get());
+//     else if (assembler.pending() > capacity)
+//         grow the buffer
+//
+// Control frames may come between the fragments of a message, they're ready by themselves.
+// Unfragmented messages are views of the fed buffer, only fragmented ones are copied, into a
+// buffer from the pool.
+class assembler {
+public:
+    struct options {
+        std::size_t max_message_size = 16 * 1024 * 1024;
+        bool masked = true; // frames from clients are, frames from servers aren't
+    };
+
+    explicit assembler(buffer_pool& pool) noexcept
+        : assembler(pool, options {})
+    {
+    }
+
+    assembler(buffer_pool& pool, options opts) noexcept
+        : m_pool { pool }
+        , m_options { opts }
+    {
+    }
+
+    assembler(const assembler&) = delete;
+    assembler& operator=(const assembler&) = delete;
+
+    ~assembler() noexcept;
+
+    // Consumes the whole frames at the start of [data, data + size), unmasking them in place, up
+    // to the end of the next message or control frame. Returns how much was consumed.
+    std::size_t feed(char* data, std::size_t size, std::error_code&);
+
+    // whether get() has a message, until the next feed()
+    bool ready() const noexcept
+    {
+        return m_ready;
+    }
+
+    const message& get() const noexcept
+    {
+        return m_message;
+    }
+
+    // the size of the incomplete frame feed() stopped at, when its header was received, 0 otherwise
+    std::size_t pending() const noexcept
+    {
+        return m_pending;
+    }
+
+private:
+    buffer_pool& m_pool;
+    options m_options;
+    std::vector<char> m_buffer; // the fragments so far
+    opcode m_type = opcode::binary;
+    bool m_fragmented = false;
+    bool m_release = false; // m_buffer, at the next feed
+    bool m_ready = false;
+    std::size_t m_pending = 0;
+    message m_message {};
+};
+
+// An unmasked frame, as servers send them, encoded once for every recipient.
+// The payload isn't copied, it must outlive the frame.
+class frame {
+public:
+    frame(opcode op, std::string_view payload, bool fin = true) noexcept
+        : m_header_size { encode_header(m_header.data(), op, payload.size(), fin) }
+        , m_payload { payload }
+    {
+    }
+
+    std::string_view header() const noexcept
+    {
+        return { m_header.data(), m_header_size };
+    }
+
+    std::string_view payload() const noexcept
+    {
+        return m_payload;
+    }
+
+    std::size_t size() const noexcept
+    {
+        return m_header_size + m_payload.size();
+    }
+
+private:
+    std::array<char, max_header_size> m_header;
+    std::size_t m_header_size;
+    std::string_view m_payload;
+};
+
+// Sends what's left of f from offset, the header and the payload with one vectored write.
+// Returns how much was sent.
+std::size_t send(socket& sock, const frame& f, std::size_t offset = 0, int flags = 0);
+std::size_t send(socket& sock, const frame& f, std::size_t offset, int flags, std::error_code&) noexcept;
+
+struct delivery {
+    std::size_t sent; // of the frame
+    std::error_code error;
+};
+
+// Sends f to every recipient without blocking, with one vectored write each, and tells in
+// results[i] how much recipients[i] took, with an error only when it failed. The rest of a partially sent frame must follow, with
+// send() from that offset, before anything else is sent to that socket.
+// Returns how many recipients took the whole frame.
+std::size_t broadcast(const frame& f, socket* const* recipients, std::size_t count, delivery* results) noexcept;
+
+inline std::size_t broadcast(const frame& f, const std::vector<socket*>& recipients, std::vector<delivery>& results)
+{
+    results.resize(recipients.size());
+    return broadcast(f, recipients.data(), recipients.size(), results.data());
+}
+
+} // namespace net::websocket
+
+namespace std {
+
+template <>
+struct is_error_code_enum<net::websocket::errc> : true_type {
+};
+
+} // namespace std
@@ -3,28 +3,18 @@
 #include <cppnet/getaddrinfo.hpp>
 
 #ifdef _WIN32
-#define ERROR_NUMBER WSAGetLastError()
 #include <ws2tcpip.h>
-#else
-#define ERROR_NUMBER errno
 #endif
 
 net::address net::address::from_ipv4(std::string_view host, std::uint16_t port)
 {
-    sockaddr_in addr {};
-    constexpr size_t len = sizeof(addr);
-
-    addr.sin_family = AF_INET;
-    int result = inet_pton(AF_INET, host.data(), &addr.sin_addr);
-    if (result == 0)
+    address ret;
+    const char *last = host.data() + host.size();
+    auto [end, ec] = net::from_chars(host.data(), last, ret);
+    if (ec != std::errc {} || end != last || ret.family() != AF_INET || host.find(':') != std::string_view::npos)
         throw std::invalid_argument("the address was not parseable in the specified address family");
-    else if (result == -1)
-        throw std::system_error(ERROR_NUMBER, std::system_category());
-    addr.sin_port = htons(port);
 
-    address ret;
-    std::memcpy(&ret.m_socket_address, &addr, len);
-    ret.m_socket_address_size = len;
+    reinterpret_cast<sockaddr_in *>(&ret.m_socket_address)->sin_port = htons(port);
     return ret;
 }
 
@@ -60,22 +50,16 @@ net::address net::address::from_ipv4(net::localhost_t, std::uint16_t port) noexc
 
 net::address net::address::from_ipv6(std::string_view host, std::uint16_t port, std::uint32_t flowinfo, std::uint32_t scopeid)
 {
-    sockaddr_in6 addr {};
-    constexpr size_t len = sizeof(addr);
-
-    addr.sin6_family = AF_INET6;
-    int result = inet_pton(AF_INET6, host.data(), &addr.sin6_addr);
-    if (result == 0)
+    address ret;
+    const char *last = host.data() + host.size();
+    auto [end, ec] = net::from_chars(host.data(), last, ret);
+    if (ec != std::errc {} || end != last || ret.family() != AF_INET6 || host.find_first_of("[%") != std::string_view::npos)
         throw std::invalid_argument("the address was not parseable in the specified address family");
-    else if (result == -1)
-        throw std::system_error(ERROR_NUMBER, std::system_category());
-    addr.sin6_port = htons(port);
-    addr.sin6_flowinfo = flowinfo;
-    addr.sin6_scope_id = scopeid;
 
-    address ret;
-    std::memcpy(&ret.m_socket_address, &addr, len);
-    ret.m_socket_address_size = len;
+    auto addr = reinterpret_cast<sockaddr_in6 *>(&ret.m_socket_address);
+    addr->sin6_port = htons(port);
+    addr->sin6_flowinfo = flowinfo;
+    addr->sin6_scope_id = scopeid;
     return ret;
 }
 
@@ -132,51 +116,20 @@ net::address net::address::from_unix(std::string_view path)
 }
 #endif
 
+#include <cstddef>
+#include <iterator>
 #include <ostream>
 
-#ifndef _WIN32
-#include <arpa/inet.h>
-#include <mstcpip.h>
-#endif
-
 namespace net {
 
     std::ostream &operator<<(std::ostream &os, address const &address)
     {
         switch (address.address_pointer()->ss_family) {
-        case AF_INET: {
-            char buffer[64] {};
-            auto in_addr = reinterpret_cast<sockaddr_in const *>(address.address_pointer());
-#if _WIN32
-            ULONG size = std::size(buffer);
-            RtlIpv4AddressToStringExA(&in_addr->sin_addr, 0, std::data(buffer), &size);
-#else
-            inet_ntop(AF_INET, &in_addr->sin_addr, std::data(buffer), std::size(buffer));
-#endif
-
-            if (std::uint16_t port = htons(in_addr->sin_port); port) {
-                os << &buffer[0] << ':' << port;
-            } else {
-                os << &buffer[0];
-            }
-
-        } break;
+        case AF_INET:
         case AF_INET6: {
-            char buffer[64] {};
-
-            auto in6_addr = reinterpret_cast<sockaddr_in6 const *>(address.address_pointer());
-#if _WIN32
-            ULONG size = std::size(buffer);
-            RtlIpv6AddressToStringExA(&in6_addr->sin6_addr, 0, 0, std::data(buffer), &size);
-#else
-            inet_ntop(AF_INET6, &in6_addr->sin6_addr, std::data(buffer), std::size(buffer));
-#endif
-
-            if (std::uint16_t port = htons(in6_addr->sin6_port); port) {
-                os << '[' << &buffer[0] << ']' << ':' << port;
-            } else {
-                os << '[' << &buffer[0] << ']';
-            }
+            char buffer[max_ip_address_chars];
+            auto result = to_chars(std::begin(buffer), std::end(buffer), address);
+            os.write(buffer, result.ptr - buffer);
         } break;
 #ifndef _WIN32
         case AF_UNIX: {
@@ -190,4 +143,156 @@ namespace net {
 
         return os;
     }
+
+#ifndef _WIN32
+    static std::size_t unix_path_size(address const &addr) noexcept
+    {
+        constexpr std::size_t offset = offsetof(sockaddr_un, sun_path);
+        return addr.address_size() > offset ? addr.address_size() - offset : 0;
+    }
+#endif
+
+    bool operator==(address const &lhs, address const &rhs) noexcept
+    {
+        if (lhs.family() != rhs.family())
+            return false;
+
+        switch (lhs.family()) {
+        case AF_INET: {
+            auto l = reinterpret_cast<sockaddr_in const *>(lhs.address_pointer());
+            auto r = reinterpret_cast<sockaddr_in const *>(rhs.address_pointer());
+            return l->sin_port == r->sin_port && l->sin_addr.s_addr == r->sin_addr.s_addr;
+        }
+        case AF_INET6: {
+            auto l = reinterpret_cast<sockaddr_in6 const *>(lhs.address_pointer());
+            auto r = reinterpret_cast<sockaddr_in6 const *>(rhs.address_pointer());
+            return l->sin6_port == r->sin6_port
+                && l->sin6_scope_id == r->sin6_scope_id
+                && std::memcmp(&l->sin6_addr, &r->sin6_addr, sizeof(l->sin6_addr)) == 0;
+        }
+#ifndef _WIN32
+        case AF_UNIX: {
+            auto l = reinterpret_cast<sockaddr_un const *>(lhs.address_pointer());
+            auto r = reinterpret_cast<sockaddr_un const *>(rhs.address_pointer());
+            if (l->sun_path[0] == '\0' || r->sun_path[0] == '\0') { // unnamed or abstract, every byte counts
+                std::size_t size = unix_path_size(lhs);
+                return size == unix_path_size(rhs) && std::memcmp(l->sun_path, r->sun_path, size) == 0;
+            }
+            return std::strncmp(l->sun_path, r->sun_path, sizeof(l->sun_path)) == 0;
+        }
+#endif
+        case address::invalid_family:
+            return true;
+        default:
+            return lhs.address_size() == rhs.address_size()
+                && std::memcmp(lhs.address_pointer(), rhs.address_pointer(), lhs.address_size()) == 0;
+        }
+    }
+
+    static int compare_bytes(void const *lhs, std::size_t lhs_size, void const *rhs, std::size_t rhs_size) noexcept
+    {
+        int order = std::memcmp(lhs, rhs, lhs_size < rhs_size ? lhs_size : rhs_size);
+        if (order)
+            return order;
+        return lhs_size < rhs_size ? -1 : lhs_size > rhs_size;
+    }
+
+    static int compare(address const &lhs, address const &rhs) noexcept
+    {
+        if (lhs.family() != rhs.family())
+            return lhs.family() < rhs.family() ? -1 : 1;
+
+        switch (lhs.family()) {
+        case AF_INET: {
+            auto l = reinterpret_cast<sockaddr_in const *>(lhs.address_pointer());
+            auto r = reinterpret_cast<sockaddr_in const *>(rhs.address_pointer());
+            if (int order = std::memcmp(&l->sin_addr, &r->sin_addr, sizeof(l->sin_addr)))
+                return order;
+            return ntohs(l->sin_port) - ntohs(r->sin_port);
+        }
+        case AF_INET6: {
+            auto l = reinterpret_cast<sockaddr_in6 const *>(lhs.address_pointer());
+            auto r = reinterpret_cast<sockaddr_in6 const *>(rhs.address_pointer());
+            if (int order = std::memcmp(&l->sin6_addr, &r->sin6_addr, sizeof(l->sin6_addr)))
+                return order;
+            if (l->sin6_port != r->sin6_port)
+                return ntohs(l->sin6_port) - ntohs(r->sin6_port);
+            return l->sin6_scope_id < r->sin6_scope_id ? -1 : l->sin6_scope_id > r->sin6_scope_id;
+        }
+#ifndef _WIN32
+        case AF_UNIX: {
+            auto l = reinterpret_cast<sockaddr_un const *>(lhs.address_pointer());
+            auto r = reinterpret_cast<sockaddr_un const *>(rhs.address_pointer());
+            std::size_t l_size = l->sun_path[0] == '\0' ? unix_path_size(lhs) : ::strnlen(l->sun_path, sizeof(l->sun_path));
+            std::size_t r_size = r->sun_path[0] == '\0' ? unix_path_size(rhs) : ::strnlen(r->sun_path, sizeof(r->sun_path));
+            return compare_bytes(l->sun_path, l_size, r->sun_path, r_size);
+        }
+#endif
+        case address::invalid_family:
+            return 0;
+        default:
+            return compare_bytes(lhs.address_pointer(), lhs.address_size(), rhs.address_pointer(), rhs.address_size());
+        }
+    }
+
+    bool operator<(address const &lhs, address const &rhs) noexcept
+    {
+        return compare(lhs, rhs) < 0;
+    }
+
+    // splitmix64 finalizer, cheap and good enough for hash tables
+    static std::uint64_t mix(std::uint64_t x) noexcept
+    {
+        x ^= x >> 30;
+        x *= 0xbf58476d1ce4e5b9;
+        x ^= x >> 27;
+        x *= 0x94d049bb133111eb;
+        x ^= x >> 31;
+        return x;
+    }
+
+    static std::uint64_t hash_bytes(void const *data, std::size_t size, std::uint64_t seed) noexcept
+    {
+        auto bytes = static_cast<unsigned char const *>(data);
+        std::uint64_t h = seed;
+        while (size >= sizeof(std::uint64_t)) {
+            std::uint64_t word;
+            std::memcpy(&word, bytes, sizeof(word));
+            h = mix(h ^ word);
+            bytes += sizeof(word);
+            size -= sizeof(word);
+        }
+        std::uint64_t tail = 0;
+        std::memcpy(&tail, bytes, size);
+        return mix(h ^ tail ^ size);
+    }
+
+} // namespace net
+
+std::size_t std::hash<net::address>::operator()(net::address const &addr) const noexcept
+{
+    std::uint64_t family = addr.family();
+    switch (addr.family()) {
+    case AF_INET: {
+        auto in = reinterpret_cast<sockaddr_in const *>(addr.address_pointer());
+        std::uint64_t key = std::uint64_t(in->sin_addr.s_addr) << 16 | in->sin_port;
+        return static_cast<std::size_t>(net::mix(key ^ family << 48));
+    }
+    case AF_INET6: {
+        auto in6 = reinterpret_cast<sockaddr_in6 const *>(addr.address_pointer());
+        std::uint64_t seed = family << 48 | std::uint64_t(in6->sin6_scope_id) << 16 | in6->sin6_port;
+        return static_cast<std::size_t>(net::hash_bytes(&in6->sin6_addr, sizeof(in6->sin6_addr), seed));
+    }
+#ifndef _WIN32
+    case AF_UNIX: {
+        auto un = reinterpret_cast<sockaddr_un const *>(addr.address_pointer());
+        std::size_t size = un->sun_path[0] == '\0' ? net::unix_path_size(addr) : ::strnlen(un->sun_path, sizeof(un->sun_path));
+        return static_cast<std::size_t>(net::hash_bytes(un->sun_path, size, family));
+    }
+#endif
+    case net::address::invalid_family:
+        return static_cast<std::size_t>(net::mix(family));
+    default:
+        return static_cast<std::size_t>(net::hash_bytes(addr.address_pointer(), addr.address_size(), family));
+    }
 }
\ No newline at end of file
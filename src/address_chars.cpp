@@ -0,0 +1,352 @@
+#define _WIN32_WINNT 0x601 // Windows 7
+#include <cppnet/address.hpp>
+
+#ifdef _WIN32
+#include <ws2tcpip.h>
+#endif
+
+// Hand written scalar parsing and formatting, without inet_pton/inet_ntop, locales, streams nor
+// allocations. The accepted and produced texts are those of glibc: no leading zeros in IPv4 octets,
+// RFC 5952 IPv6 text, with a dotted quad in the IPv4 mapped and IPv4 compatible addresses.
+
+namespace {
+
+    bool is_digit(char c) noexcept
+    {
+        return static_cast<unsigned char>(c - '0') < 10;
+    }
+
+    struct hex_table {
+        signed char values[256];
+
+        constexpr hex_table()
+            : values {}
+        {
+            for (int i = 0; i < 256; ++i)
+                values[i] = -1;
+            for (int i = 0; i < 10; ++i)
+                values['0' + i] = static_cast<signed char>(i);
+            for (int i = 0; i < 6; ++i) {
+                values['a' + i] = static_cast<signed char>(10 + i);
+                values['A' + i] = static_cast<signed char>(10 + i);
+            }
+        }
+    };
+
+    constexpr hex_table hex_values;
+
+    int hex_value(char c) noexcept
+    {
+        return hex_values.values[static_cast<unsigned char>(c)];
+    }
+
+    // a dotted quad, returns past it or nullptr
+    const char *parse_ipv4(const char *p, const char *last, std::uint8_t *out) noexcept
+    {
+        for (int i = 0; i < 4; ++i) {
+            if (i) {
+                if (p == last || *p != '.')
+                    return nullptr;
+                ++p;
+            }
+            if (p == last || !is_digit(*p))
+                return nullptr;
+            unsigned value = static_cast<unsigned>(*p++ - '0');
+            if (value == 0 && p != last && is_digit(*p))
+                return nullptr; // no octal, as inet_pton
+            for (int digits = 1; digits < 3 && p != last && is_digit(*p); ++digits)
+                value = value * 10 + static_cast<unsigned>(*p++ - '0');
+            if (value > 255 || (p != last && is_digit(*p)))
+                return nullptr;
+            out[i] = static_cast<std::uint8_t>(value);
+        }
+        return p;
+    }
+
+    // RFC 4291 text, returns past it or nullptr
+    const char *parse_ipv6(const char *p, const char *last, std::uint8_t *out) noexcept
+    {
+        std::uint16_t words[8] {};
+        int count = 0;
+        int gap = -1;
+
+        if (last - p >= 2 && p[0] == ':' && p[1] == ':') {
+            gap = 0;
+            p += 2;
+            if (p == last || hex_value(*p) < 0)
+                goto done;
+        }
+
+        for (;;) {
+            const char *group = p;
+            unsigned value = 0;
+            int digits = 0;
+            for (int v; digits < 4 && p != last && (v = hex_value(*p)) >= 0; ++digits, ++p)
+                value = value << 4 | static_cast<unsigned>(v);
+            if (digits == 0)
+                return nullptr;
+
+            if (p != last && *p == '.') { // the last 32 bits as a dotted quad
+                if (count > 6)
+                    return nullptr;
+                std::uint8_t quad[4];
+                p = parse_ipv4(group, last, quad);
+                if (!p)
+                    return nullptr;
+                words[count++] = static_cast<std::uint16_t>(quad[0] << 8 | quad[1]);
+                words[count++] = static_cast<std::uint16_t>(quad[2] << 8 | quad[3]);
+                break;
+            }
+            if (count == 8 || (p != last && hex_value(*p) >= 0))
+                return nullptr;
+            words[count++] = static_cast<std::uint16_t>(value);
+
+            if (p == last || *p != ':')
+                break;
+            if (last - p >= 2 && p[1] == ':') {
+                if (gap >= 0)
+                    return nullptr;
+                gap = count;
+                p += 2;
+                if (p == last || hex_value(*p) < 0)
+                    break;
+            } else {
+                ++p;
+                if (p == last || hex_value(*p) < 0)
+                    return nullptr;
+            }
+        }
+
+    done:
+        if (gap < 0 ? count != 8 : count > 7)
+            return nullptr;
+        if (gap >= 0) {
+            int moved = count - gap;
+            for (int i = 0; i < moved; ++i)
+                words[7 - i] = words[count - 1 - i];
+            for (int i = gap; i < 8 - moved; ++i)
+                words[i] = 0;
+        }
+        for (int i = 0; i < 8; ++i) {
+            out[2 * i] = static_cast<std::uint8_t>(words[i] >> 8);
+            out[2 * i + 1] = static_cast<std::uint8_t>(words[i]);
+        }
+        return p;
+    }
+
+    // ":port", leaves p at the colon when there are no digits after it
+    const char *parse_port(const char *p, const char *last, std::uint16_t &port, std::errc &ec) noexcept
+    {
+        if (p == last || *p != ':' || p + 1 == last || !is_digit(p[1]))
+            return p;
+        ++p;
+        std::uint32_t value = 0;
+        while (p != last && is_digit(*p)) {
+            value = value * 10 + static_cast<std::uint32_t>(*p++ - '0');
+            if (value > 65535) {
+                ec = std::errc::result_out_of_range;
+                while (p != last && is_digit(*p))
+                    ++p;
+                return p;
+            }
+        }
+        port = static_cast<std::uint16_t>(value);
+        return p;
+    }
+
+    // "%" and a numeric scope id, leaves p at the percent sign when there are no digits after it
+    const char *parse_scope(const char *p, const char *last, std::uint32_t &scope, std::errc &ec) noexcept
+    {
+        if (p == last || *p != '%' || p + 1 == last || !is_digit(p[1]))
+            return p;
+        ++p;
+        std::uint64_t value = 0;
+        while (p != last && is_digit(*p)) {
+            value = value * 10 + static_cast<std::uint64_t>(*p++ - '0');
+            if (value > UINT32_MAX) {
+                ec = std::errc::result_out_of_range;
+                while (p != last && is_digit(*p))
+                    ++p;
+                return p;
+            }
+        }
+        scope = static_cast<std::uint32_t>(value);
+        return p;
+    }
+
+    char *write_decimal(char *p, std::uint32_t value) noexcept
+    {
+        char digits[10];
+        int count = 0;
+        do {
+            digits[count++] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value);
+        while (count)
+            *p++ = digits[--count];
+        return p;
+    }
+
+    char *write_ipv4(char *p, const std::uint8_t *bytes) noexcept
+    {
+        for (int i = 0; i < 4; ++i) {
+            if (i)
+                *p++ = '.';
+            unsigned value = bytes[i];
+            if (value >= 100) {
+                *p++ = static_cast<char>('0' + value / 100);
+                value %= 100;
+                *p++ = static_cast<char>('0' + value / 10);
+            } else if (value >= 10) {
+                *p++ = static_cast<char>('0' + value / 10);
+            }
+            *p++ = static_cast<char>('0' + value % 10);
+        }
+        return p;
+    }
+
+    char *write_ipv6(char *p, const std::uint8_t *bytes) noexcept
+    {
+        constexpr char hex[] = "0123456789abcdef";
+        std::uint16_t words[8];
+        for (int i = 0; i < 8; ++i)
+            words[i] = static_cast<std::uint16_t>(bytes[2 * i] << 8 | bytes[2 * i + 1]);
+
+        // the first longest run of at least two zero groups is compressed
+        int best = -1, best_length = 0;
+        for (int i = 0; i < 8;) {
+            if (words[i] != 0) {
+                ++i;
+                continue;
+            }
+            int start = i;
+            while (i < 8 && words[i] == 0)
+                ++i;
+            if (i - start > best_length) {
+                best = start;
+                best_length = i - start;
+            }
+        }
+        if (best_length < 2)
+            best = -1;
+
+        for (int i = 0; i < 8; ++i) {
+            if (i == best) {
+                *p++ = ':';
+                if (best + best_length == 8)
+                    *p++ = ':';
+                i += best_length - 1;
+                continue;
+            }
+            if (i)
+                *p++ = ':';
+            // ::a.b.c.d and ::ffff:a.b.c.d
+            if (i == 6 && best == 0 && (best_length == 6 || (best_length == 5 && words[5] == 0xffff)))
+                return write_ipv4(p, bytes + 12);
+            std::uint16_t word = words[i];
+            bool started = false;
+            for (int shift = 12; shift >= 0; shift -= 4) {
+                unsigned nibble = (word >> shift) & 0xf;
+                if (nibble || started || shift == 0) {
+                    *p++ = hex[nibble];
+                    started = true;
+                }
+            }
+        }
+        return p;
+    }
+
+}
+
+namespace net {
+
+    std::from_chars_result from_chars(const char *first, const char *last, address &addr) noexcept
+    {
+        std::errc ec {};
+
+        // IPv4, with an optional port
+        sockaddr_in in {};
+        if (const char *p = parse_ipv4(first, last, reinterpret_cast<std::uint8_t *>(&in.sin_addr))) {
+            std::uint16_t port = 0;
+            p = parse_port(p, last, port, ec);
+            if (ec != std::errc {})
+                return { p, ec };
+            in.sin_family = AF_INET;
+            in.sin_port = htons(port);
+            addr = address { reinterpret_cast<sockaddr const *>(&in), sizeof(in) };
+            return { p, ec };
+        }
+
+        // IPv6, bracketed with an optional port, or bare
+        sockaddr_in6 in6 {};
+        bool bracketed = first != last && *first == '[';
+        const char *p = parse_ipv6(first + bracketed, last, reinterpret_cast<std::uint8_t *>(&in6.sin6_addr));
+        if (!p)
+            return { first, std::errc::invalid_argument };
+        p = parse_scope(p, last, in6.sin6_scope_id, ec);
+        if (ec != std::errc {})
+            return { p, ec };
+        std::uint16_t port = 0;
+        if (bracketed) {
+            if (p == last || *p != ']')
+                return { first, std::errc::invalid_argument };
+            p = parse_port(p + 1, last, port, ec);
+            if (ec != std::errc {})
+                return { p, ec };
+        }
+        in6.sin6_family = AF_INET6;
+        in6.sin6_port = htons(port);
+        addr = address { reinterpret_cast<sockaddr const *>(&in6), sizeof(in6) };
+        return { p, ec };
+    }
+
+    std::to_chars_result to_chars(char *first, char *last, address const &addr) noexcept
+    {
+        char buffer[max_ip_address_chars];
+        char *p = buffer;
+
+        switch (addr.family()) {
+        case AF_INET: {
+            auto in = reinterpret_cast<sockaddr_in const *>(addr.address_pointer());
+            p = write_ipv4(p, reinterpret_cast<std::uint8_t const *>(&in->sin_addr));
+            if (std::uint16_t port = ntohs(in->sin_port)) {
+                *p++ = ':';
+                p = write_decimal(p, port);
+            }
+        } break;
+        case AF_INET6: {
+            auto in6 = reinterpret_cast<sockaddr_in6 const *>(addr.address_pointer());
+            *p++ = '[';
+            p = write_ipv6(p, reinterpret_cast<std::uint8_t const *>(&in6->sin6_addr));
+            if (in6->sin6_scope_id) {
+                *p++ = '%';
+                p = write_decimal(p, in6->sin6_scope_id);
+            }
+            *p++ = ']';
+            if (std::uint16_t port = ntohs(in6->sin6_port)) {
+                *p++ = ':';
+                p = write_decimal(p, port);
+            }
+        } break;
+#ifndef _WIN32
+        case AF_UNIX: {
+            auto un = reinterpret_cast<sockaddr_un const *>(addr.address_pointer());
+            std::size_t size = strnlen(un->sun_path, sizeof(un->sun_path));
+            if (static_cast<std::size_t>(last - first) < size)
+                return { last, std::errc::value_too_large };
+            std::memcpy(first, un->sun_path, size);
+            return { first + size, std::errc {} };
+        }
+#endif
+        default:
+            return { first, std::errc::address_family_not_supported };
+        }
+
+        std::size_t size = static_cast<std::size_t>(p - buffer);
+        if (static_cast<std::size_t>(last - first) < size)
+            return { last, std::errc::value_too_large };
+        std::memcpy(first, buffer, size);
+        return { first + size, std::errc {} };
+    }
+
+} // namespace net
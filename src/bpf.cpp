@@ -0,0 +1,227 @@
+#ifdef __linux__
+#include <cppnet/bpf.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+#define THROW_IF_ERROR(e) \
+    if (e)                \
+    throw std::system_error(e)
+
+void net::attach_reuseport_filter(socket& sock, const bpf_program& program)
+{
+    std::error_code e;
+    attach_reuseport_filter(sock, program, e);
+    THROW_IF_ERROR(e);
+}
+
+void net::attach_reuseport_filter(socket& sock, const bpf_program& program, std::error_code& e) noexcept
+{
+    sock_fprog fprog = program.native();
+    sock.setsockopt(SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &fprog, sizeof(fprog), e);
+}
+
+void net::detach_reuseport_filter(socket& sock)
+{
+    std::error_code e;
+    detach_reuseport_filter(sock, e);
+    THROW_IF_ERROR(e);
+}
+
+void net::detach_reuseport_filter(socket& sock, std::error_code& e) noexcept
+{
+    int unused = 0;
+    sock.setsockopt(SOL_SOCKET, SO_DETACH_REUSEPORT_BPF, &unused, sizeof(unused), e);
+}
+
+void net::attach_filter(socket& sock, const bpf_program& program)
+{
+    std::error_code e;
+    attach_filter(sock, program, e);
+    THROW_IF_ERROR(e);
+}
+
+void net::attach_filter(socket& sock, const bpf_program& program, std::error_code& e) noexcept
+{
+    sock_fprog fprog = program.native();
+    sock.setsockopt(SOL_SOCKET, SO_ATTACH_FILTER, &fprog, sizeof(fprog), e);
+}
+
+void net::detach_filter(socket& sock)
+{
+    std::error_code e;
+    detach_filter(sock, e);
+    THROW_IF_ERROR(e);
+}
+
+void net::detach_filter(socket& sock, std::error_code& e) noexcept
+{
+    int unused = 0;
+    sock.setsockopt(SOL_SOCKET, SO_DETACH_FILTER, &unused, sizeof(unused), e);
+}
+
+void net::lock_filter(socket& sock)
+{
+    std::error_code e;
+    lock_filter(sock, e);
+    THROW_IF_ERROR(e);
+}
+
+void net::lock_filter(socket& sock, std::error_code& e) noexcept
+{
+    int enable = 1;
+    sock.setsockopt(SOL_SOCKET, SO_LOCK_FILTER, &enable, sizeof(enable), e);
+}
+
+net::bpf_filter_builder& net::bpf_filter_builder::length_between(std::uint32_t min, std::uint32_t max)
+{
+    m_checks.push_back({ BPF_LD | BPF_W | BPF_LEN, 0, 0xffffffff, m_base + min, m_base + max });
+    return *this;
+}
+
+net::bpf_filter_builder& net::bpf_filter_builder::byte_equals(std::uint32_t offset, std::uint8_t value, std::uint8_t mask)
+{
+    m_checks.push_back({ BPF_LD | BPF_B | BPF_ABS, m_base + offset, mask, std::uint32_t(value & mask), std::uint32_t(value & mask) });
+    return *this;
+}
+
+net::bpf_filter_builder& net::bpf_filter_builder::half_equals(std::uint32_t offset, std::uint16_t value, std::uint16_t mask)
+{
+    m_checks.push_back({ BPF_LD | BPF_H | BPF_ABS, m_base + offset, mask, std::uint32_t(value & mask), std::uint32_t(value & mask) });
+    return *this;
+}
+
+net::bpf_filter_builder& net::bpf_filter_builder::word_equals(std::uint32_t offset, std::uint32_t value, std::uint32_t mask)
+{
+    m_checks.push_back({ BPF_LD | BPF_W | BPF_ABS, m_base + offset, mask, std::uint32_t(value & mask), std::uint32_t(value & mask) });
+    return *this;
+}
+
+net::bpf_filter_builder& net::bpf_filter_builder::byte_between(std::uint32_t offset, std::uint8_t min, std::uint8_t max)
+{
+    m_checks.push_back({ BPF_LD | BPF_B | BPF_ABS, m_base + offset, 0xff, min, max });
+    return *this;
+}
+
+net::bpf_program net::bpf_filter_builder::build() const
+{
+    // every check jumps forward to the final "ret #0" when it fails.
+    // Loads past the end of the packet make the kernel drop it too.
+    std::vector<sock_filter> code;
+    std::vector<std::pair<std::size_t, bool>> jumps_to_drop; // instruction, drop when true
+
+    auto jump = [&](std::uint16_t op, std::uint32_t k, bool drop_if_true) {
+        jumps_to_drop.emplace_back(code.size(), drop_if_true);
+        code.push_back(BPF_JUMP(BPF_JMP | op | BPF_K, k, 0, 0));
+    };
+
+    for (const check& c : m_checks) {
+        code.push_back(BPF_STMT(c.load, c.offset));
+        if (c.mask != 0xffffffff)
+            code.push_back(BPF_STMT(BPF_ALU | BPF_AND | BPF_K, c.mask));
+        if (c.min == c.max)
+            jump(BPF_JEQ, c.min, false); // A != value: drop
+        else {
+            jump(BPF_JGE, c.min, false); // A < min: drop
+            jump(BPF_JGT, c.max, true); // A > max: drop
+        }
+    }
+    code.push_back(BPF_STMT(BPF_RET | BPF_K, 0xffffffff)); // accept, whole packet
+    std::size_t drop = code.size();
+    code.push_back(BPF_STMT(BPF_RET | BPF_K, 0)); // drop
+
+    for (auto [i, drop_if_true] : jumps_to_drop) {
+        std::size_t distance = drop - (i + 1);
+        if (distance > 0xff)
+            throw std::length_error("too many checks for a classic BPF filter");
+        if (drop_if_true)
+            code[i].jt = static_cast<std::uint8_t>(distance);
+        else
+            code[i].jf = static_cast<std::uint8_t>(distance);
+    }
+
+    bpf_program program;
+    for (const sock_filter& ins : code)
+        program.push_back(ins);
+    return program;
+}
+
+net::bpf_program net::source_filter(const std::vector<filter_rule>& rules, filter_action default_action)
+{
+    auto verdict = [](filter_action action) -> sock_filter {
+        return BPF_STMT(BPF_RET | BPF_K, action == filter_action::allow ? 0xffffffff : 0);
+    };
+
+    // first match wins once the longest prefixes come first
+    std::vector<filter_rule> sorted = rules;
+    std::stable_sort(sorted.begin(), sorted.end(), [](const filter_rule& a, const filter_rule& b) {
+        return a.prefix.length() > b.prefix.length();
+    });
+
+    // the words of the source address are kept in the scratch memory, M[0] to M[3]
+    auto add_rules = [&](std::vector<sock_filter>& code, int family) {
+        for (const filter_rule& rule : sorted) {
+            if (rule.prefix.family() != family)
+                continue;
+            unsigned length = rule.prefix.length();
+            if (length == 0) {
+                code.push_back(verdict(rule.action));
+                return; // everything matches it
+            }
+
+            std::size_t words = (length + 31) / 32;
+            std::vector<sock_filter> checks;
+            for (std::size_t i = 0; i < words; ++i) {
+                const std::uint8_t* bytes = rule.prefix.bytes().data() + 4 * i;
+                std::uint32_t value = std::uint32_t { bytes[0] } << 24 | std::uint32_t { bytes[1] } << 16 | std::uint32_t { bytes[2] } << 8 | bytes[3];
+                unsigned bits = std::min(32u, length - static_cast<unsigned>(32 * i));
+                std::uint32_t mask = bits == 32 ? 0xffffffff : ~(0xffffffffu >> bits);
+                checks.push_back(BPF_STMT(BPF_LD | BPF_MEM, static_cast<std::uint32_t>(i)));
+                if (mask != 0xffffffff)
+                    checks.push_back(BPF_STMT(BPF_ALU | BPF_AND | BPF_K, mask));
+                checks.push_back(BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, value, 0, 0));
+            }
+            checks.push_back(verdict(rule.action));
+            // a mismatch skips to the next rule, past the verdict
+            for (std::size_t i = 0; i < checks.size(); ++i) {
+                if (BPF_CLASS(checks[i].code) == BPF_JMP)
+                    checks[i].jf = static_cast<std::uint8_t>(checks.size() - i - 1);
+            }
+            code.insert(code.end(), checks.begin(), checks.end());
+        }
+        code.push_back(verdict(default_action));
+    };
+
+    std::vector<sock_filter> ipv4;
+    ipv4.push_back(BPF_STMT(BPF_LD | BPF_W | BPF_ABS, static_cast<std::uint32_t>(SKF_NET_OFF + 12)));
+    ipv4.push_back(BPF_STMT(BPF_ST, 0));
+    add_rules(ipv4, AF_INET);
+
+    std::vector<sock_filter> ipv6;
+    for (std::uint32_t i = 0; i < 4; ++i) {
+        ipv6.push_back(BPF_STMT(BPF_LD | BPF_W | BPF_ABS, static_cast<std::uint32_t>(SKF_NET_OFF + 8) + 4 * i));
+        ipv6.push_back(BPF_STMT(BPF_ST, i));
+    }
+    add_rules(ipv6, AF_INET6);
+
+    std::vector<sock_filter> code;
+    code.push_back(BPF_STMT(BPF_LD | BPF_B | BPF_ABS, static_cast<std::uint32_t>(SKF_NET_OFF))); // the IP version
+    code.push_back(BPF_STMT(BPF_ALU | BPF_RSH | BPF_K, 4));
+    code.push_back(BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 4, 1, 0));
+    code.push_back(BPF_STMT(BPF_JMP | BPF_JA, static_cast<std::uint32_t>(ipv4.size())));
+    code.insert(code.end(), ipv4.begin(), ipv4.end());
+    code.push_back(BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 6, 1, 0));
+    code.push_back(verdict(filter_action::allow)); // not IP, not ours to judge
+    code.insert(code.end(), ipv6.begin(), ipv6.end());
+
+    if (code.size() > BPF_MAXINSNS)
+        throw std::length_error("too many rules for a classic BPF filter");
+
+    bpf_program program;
+    for (const sock_filter& ins : code)
+        program.push_back(ins);
+    return program;
+}
+
+#endif
@@ -0,0 +1,237 @@
+#define _WIN32_WINNT 0x601 // Windows 7
+#include <cppnet/connect.hpp>
+
+#include <algorithm>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#else
+#include <poll.h>
+#endif
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+bool in_progress(const std::error_code& e) noexcept
+{
+    return e == std::errc::operation_in_progress || e == std::errc::operation_would_block;
+}
+
+// first family of the list first, then alternating, keeping the relative order inside each family
+std::vector<std::size_t> interleave(const net::connect_candidate* candidates, std::size_t count)
+{
+    std::vector<std::size_t> preferred, others, order;
+    for (std::size_t i = 0; i < count; ++i)
+        (candidates[i].family == candidates[0].family ? preferred : others).push_back(i);
+
+    order.reserve(count);
+    for (std::size_t i = 0; i < preferred.size() || i < others.size(); ++i) {
+        if (i < preferred.size())
+            order.push_back(preferred[i]);
+        if (i < others.size())
+            order.push_back(others[i]);
+    }
+    return order;
+}
+
+int poll_timeout(clock_type::duration d) noexcept
+{
+    auto ms = std::chrono::ceil<std::chrono::milliseconds>(d).count();
+    return static_cast<int>(std::clamp<decltype(ms)>(ms, 0, 1 << 30));
+}
+
+}
+
+bool net::async_connect::start(socket& sock, const sockaddr* addr, size_t addr_size, std::optional<std::chrono::milliseconds> timeout, std::error_code& e) noexcept
+{
+    m_socket = nullptr;
+    sock.setblocking(false, e);
+    if (e)
+        return true;
+    sock.connect(addr, addr_size, e);
+    if (!in_progress(e)) // loopback and unix sockets may connect right away
+        return true;
+
+    e.assign(0, std::system_category());
+    m_socket = &sock;
+    if (timeout)
+        m_deadline = clock::now() + *timeout;
+    else
+        m_deadline.reset();
+    return false;
+}
+
+void net::async_connect::finish(std::error_code& e) noexcept
+{
+    if (!m_socket) {
+        e = std::make_error_code(std::errc::invalid_argument);
+        return;
+    }
+    e = m_socket->error();
+    m_socket = nullptr;
+}
+
+std::optional<std::chrono::milliseconds> net::async_connect::remaining() const noexcept
+{
+    if (!m_socket || !m_deadline)
+        return std::nullopt;
+    auto now = clock::now();
+    if (now >= *m_deadline)
+        return std::chrono::milliseconds::zero();
+    return std::chrono::ceil<std::chrono::milliseconds>(*m_deadline - now);
+}
+
+void net::connect(socket& sock, const address& addr, std::chrono::milliseconds timeout)
+{
+    std::error_code e;
+    connect(sock, addr, timeout, e);
+    if (e)
+        throw std::system_error(e);
+}
+
+void net::connect(socket& sock, const address& addr, std::chrono::milliseconds timeout, std::error_code& e) noexcept
+{
+    async_connect op;
+    if (!op.start(sock, reinterpret_cast<const sockaddr*>(addr.address_pointer()), addr.address_size(), timeout, e)) {
+        for (;;) {
+            auto wait = op.remaining();
+            pollfd fd { sock.native_handle(), POLLOUT, 0 };
+#ifdef _WIN32
+            int ret = ::WSAPoll(&fd, 1, static_cast<INT>(wait->count()));
+            if (ret < 0) {
+                e.assign(WSAGetLastError(), std::system_category());
+                return;
+            }
+#else
+            int ret = ::poll(&fd, 1, static_cast<int>(wait->count()));
+            if (ret < 0 && errno == EINTR)
+                continue;
+            else if (ret < 0) {
+                e.assign(errno, std::system_category());
+                return;
+            }
+#endif
+            if (ret > 0) {
+                op.finish(e);
+                break;
+            } else if (wait->count() == 0) {
+                e = std::make_error_code(std::errc::timed_out);
+                return;
+            }
+        }
+    }
+    if (e)
+        return;
+    sock.setblocking(true, e);
+}
+
+net::socket net::connect_happy_eyeballs(const connect_candidate* candidates, std::size_t count, const happy_eyeballs_options& options, std::size_t* chosen)
+{
+    std::error_code e;
+    socket sock = connect_happy_eyeballs(candidates, count, options, chosen, e);
+    if (e)
+        throw std::system_error(e);
+    return sock;
+}
+
+net::socket net::connect_happy_eyeballs(const connect_candidate* candidates, std::size_t count, const happy_eyeballs_options& options, std::size_t* chosen, std::error_code& e) noexcept try {
+    struct attempt {
+        socket sock;
+        std::size_t index;
+    };
+
+    std::vector<std::size_t> order = interleave(candidates, count);
+    std::vector<attempt> attempts;
+    std::vector<pollfd> fds;
+    attempts.reserve(count);
+    fds.reserve(count);
+
+    std::error_code last_error = std::make_error_code(std::errc::host_unreachable); // nothing to try
+    std::size_t next = 0;
+    auto now = clock_type::now();
+    auto next_start = now;
+    std::optional<clock_type::time_point> deadline;
+    if (options.timeout)
+        deadline = now + *options.timeout;
+
+    auto win = [&](attempt& a) -> socket {
+        if (options.blocking)
+            a.sock.setblocking(true, e);
+        else
+            e.assign(0, std::system_category());
+        if (e)
+            return socket {};
+        if (chosen)
+            *chosen = a.index;
+        return std::move(a.sock);
+    };
+
+    for (;;) {
+        now = clock_type::now();
+        if (deadline && now >= *deadline) {
+            e = std::make_error_code(std::errc::timed_out);
+            return {};
+        }
+
+        if (next < order.size() && (attempts.empty() || now >= next_start)) {
+            const connect_candidate& c = candidates[order[next]];
+            attempt a { socket { c.family, c.type, c.protocol, last_error }, order[next] };
+            ++next;
+            bool finished = true;
+            if (!last_error)
+                finished = async_connect {}.start(a.sock, c.address, c.address_size, std::nullopt, last_error);
+
+            if (finished && !last_error)
+                return win(a);
+            else if (!finished) {
+                attempts.push_back(std::move(a));
+                next_start = now + options.attempt_delay;
+            } else
+                next_start = now; // go straight to the next one
+            continue;
+        }
+
+        if (attempts.empty()) {
+            e = last_error;
+            return {};
+        }
+
+        auto wait = deadline ? *deadline - now : clock_type::duration::max();
+        if (next < order.size())
+            wait = std::min(wait, next_start - now);
+
+        fds.clear();
+        for (const attempt& a : attempts)
+            fds.push_back(pollfd { a.sock.native_handle(), POLLOUT, 0 });
+#ifdef _WIN32
+        int ret = ::WSAPoll(fds.data(), static_cast<ULONG>(fds.size()), wait == clock_type::duration::max() ? -1 : poll_timeout(wait));
+        if (ret < 0) {
+            e.assign(WSAGetLastError(), std::system_category());
+            return {};
+        }
+#else
+        int ret = ::poll(fds.data(), fds.size(), wait == clock_type::duration::max() ? -1 : poll_timeout(wait));
+        if (ret < 0 && errno == EINTR)
+            continue;
+        else if (ret < 0) {
+            e.assign(errno, std::system_category());
+            return {};
+        }
+#endif
+
+        // fds and attempts have the same order, walk backwards so erasing is safe
+        for (std::size_t i = fds.size(); i-- > 0;) {
+            if (!fds[i].revents)
+                continue;
+            last_error = attempts[i].sock.error();
+            if (!last_error)
+                return win(attempts[i]);
+            attempts.erase(attempts.begin() + i);
+            next_start = clock_type::now(); // a failure starts the next attempt right away
+        }
+    }
+} catch (const std::bad_alloc&) {
+    e = std::make_error_code(std::errc::not_enough_memory);
+    return {};
+}
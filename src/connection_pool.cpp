@@ -0,0 +1,243 @@
+#define _WIN32_WINNT 0x601 // Windows 7
+#include <cppnet/connection_pool.hpp>
+
+#include <algorithm>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#else
+#include <poll.h>
+#endif
+
+namespace {
+
+// An idle connection must have nothing to read: readable means either the peer closed it
+// or it sent something we didn't ask for, neither can be reused.
+bool alive(net::socket& sock) noexcept
+{
+    pollfd fd { sock.native_handle(), POLLIN, 0 };
+#ifdef _WIN32
+    int ret = ::WSAPoll(&fd, 1, 0);
+#else
+    int ret = ::poll(&fd, 1, 0);
+#endif
+    return ret == 0;
+}
+
+}
+
+net::connection_pool::connection::connection(connection&& rhs) noexcept
+    : m_pool { std::exchange(rhs.m_pool, nullptr) }
+    , m_address { rhs.m_address }
+    , m_socket { std::move(rhs.m_socket) }
+    , m_created { rhs.m_created }
+    , m_reused { rhs.m_reused }
+{
+}
+
+net::connection_pool::connection& net::connection_pool::connection::operator=(connection&& rhs) noexcept
+{
+    if (this != &rhs) {
+        release();
+        m_pool = std::exchange(rhs.m_pool, nullptr);
+        m_address = rhs.m_address;
+        m_socket = std::move(rhs.m_socket);
+        m_created = rhs.m_created;
+        m_reused = rhs.m_reused;
+    }
+    return *this;
+}
+
+void net::connection_pool::connection::release() noexcept
+{
+    if (!m_pool)
+        return;
+    if (m_socket)
+        m_pool->put_back(*this);
+    else // closed by the user
+        m_pool->forget(m_address);
+    m_pool = nullptr;
+}
+
+void net::connection_pool::connection::discard() noexcept
+{
+    if (!m_pool)
+        return;
+    if (m_socket) {
+        std::error_code e;
+        m_socket.close(e);
+    }
+    m_pool->forget(m_address);
+    m_pool = nullptr;
+}
+
+net::connection_pool::connection net::connection_pool::acquire(const address& addr)
+{
+    std::error_code e;
+    connection conn = acquire(addr, e);
+    if (e)
+        throw std::system_error(e);
+    return conn;
+}
+
+net::connection_pool::connection net::connection_pool::acquire(const address& addr, std::error_code& e) noexcept
+{
+    std::vector<idle_connection> stale; // closed outside the lock
+    try {
+        for (;;) {
+            idle_connection candidate;
+            {
+                std::lock_guard<std::mutex> lock { m_mutex };
+                backend& b = m_backends[addr];
+                auto now = clock::now();
+                while (!b.idle.empty() && !candidate.sock) {
+                    idle_connection& last = b.idle.back(); // the most recently used is the warmest
+                    if (expired(now, last.created, last.idle_since)) {
+                        stale.push_back(std::move(last));
+                        --b.live;
+                    } else
+                        candidate = std::move(last);
+                    b.idle.pop_back();
+                }
+
+                if (!candidate.sock) {
+                    if (m_options.max_connections && b.live >= m_options.max_connections) {
+                        e = std::make_error_code(std::errc::resource_unavailable_try_again);
+                        return {};
+                    }
+                    ++b.live; // reserve it while connecting
+                    break;
+                }
+            }
+
+            if (alive(candidate.sock)) {
+                connection conn;
+                conn.m_pool = this;
+                conn.m_address = addr;
+                conn.m_socket = std::move(candidate.sock);
+                conn.m_created = candidate.created;
+                conn.m_reused = true;
+                e.assign(0, std::system_category());
+                return conn;
+            }
+            forget(addr);
+        }
+    } catch (const std::bad_alloc&) {
+        e = std::make_error_code(std::errc::not_enough_memory);
+        return {};
+    }
+
+    socket sock { addr.family(), m_options.type, m_options.protocol, e };
+    if (!e)
+        sock.connect(addr, e);
+    if (e) {
+        forget(addr);
+        return {};
+    }
+
+    connection conn;
+    conn.m_pool = this;
+    conn.m_address = addr;
+    conn.m_socket = std::move(sock);
+    conn.m_created = clock::now();
+    return conn;
+}
+
+std::size_t net::connection_pool::prune() noexcept
+{
+    std::vector<idle_connection> stale;
+    std::lock_guard<std::mutex> lock { m_mutex };
+    auto now = clock::now();
+    for (auto it = m_backends.begin(); it != m_backends.end();) {
+        backend& b = it->second;
+        auto first_stale = std::stable_partition(b.idle.begin(), b.idle.end(), [&](const idle_connection& c) {
+            return !expired(now, c.created, c.idle_since);
+        });
+        std::size_t count = static_cast<std::size_t>(b.idle.end() - first_stale);
+        try {
+            stale.insert(stale.end(), std::make_move_iterator(first_stale), std::make_move_iterator(b.idle.end()));
+        } catch (const std::bad_alloc&) {
+            // they are closed right here instead
+        }
+        b.idle.erase(first_stale, b.idle.end());
+        b.live -= count;
+
+        if (b.live == 0)
+            it = m_backends.erase(it);
+        else
+            ++it;
+    }
+    return stale.size();
+}
+
+void net::connection_pool::clear() noexcept
+{
+    std::vector<std::vector<idle_connection>> stale;
+    std::lock_guard<std::mutex> lock { m_mutex };
+    for (auto it = m_backends.begin(); it != m_backends.end();) {
+        backend& b = it->second;
+        b.live -= b.idle.size();
+        try {
+            stale.push_back(std::move(b.idle));
+        } catch (const std::bad_alloc&) {
+        }
+        b.idle.clear();
+        if (b.live == 0)
+            it = m_backends.erase(it);
+        else
+            ++it;
+    }
+}
+
+std::size_t net::connection_pool::idle() const noexcept
+{
+    std::lock_guard<std::mutex> lock { m_mutex };
+    std::size_t count = 0;
+    for (const auto& [addr, b] : m_backends)
+        count += b.idle.size();
+    return count;
+}
+
+std::size_t net::connection_pool::idle(const address& addr) const noexcept
+{
+    std::lock_guard<std::mutex> lock { m_mutex };
+    auto it = m_backends.find(addr);
+    return it == m_backends.end() ? 0 : it->second.idle.size();
+}
+
+bool net::connection_pool::expired(clock::time_point now, clock::time_point created, clock::time_point idle_since) const noexcept
+{
+    if (m_options.max_age.count() && now - created >= m_options.max_age)
+        return true;
+    return now - idle_since >= m_options.max_idle_time;
+}
+
+void net::connection_pool::put_back(connection& conn) noexcept
+{
+    socket sock = std::move(conn.m_socket);
+    auto now = clock::now();
+
+    std::lock_guard<std::mutex> lock { m_mutex };
+    auto it = m_backends.find(conn.m_address);
+    if (it == m_backends.end())
+        return;
+    backend& b = it->second;
+    if (b.idle.size() < m_options.max_idle && !expired(now, conn.m_created, now)) {
+        try {
+            b.idle.push_back(idle_connection { std::move(sock), conn.m_created, now });
+            return;
+        } catch (const std::bad_alloc&) {
+        }
+    }
+    --b.live;
+}
+
+void net::connection_pool::forget(const address& addr) noexcept
+{
+    std::lock_guard<std::mutex> lock { m_mutex };
+    auto it = m_backends.find(addr);
+    if (it == m_backends.end())
+        return;
+    if (--it->second.live == 0 && it->second.idle.empty())
+        m_backends.erase(it);
+}
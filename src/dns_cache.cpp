@@ -0,0 +1,221 @@
+#include <cppnet/dns_cache.hpp>
+
+#include <algorithm>
+#include <iterator>
+
+#define THROW_IF_ERROR(e) \
+    if (e)                \
+    throw std::system_error(e)
+
+namespace {
+
+void combine(std::size_t& seed, std::size_t value) noexcept
+{
+    seed ^= value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+}
+
+}
+
+std::size_t net::dns_cache::key_hash::operator()(const key& k) const noexcept
+{
+    std::size_t seed = std::hash<std::string> {}(k.host);
+    combine(seed, std::hash<std::string> {}(k.service));
+    for (int field : { k.family, k.type, k.protocol, k.flags })
+        combine(seed, static_cast<unsigned>(field));
+    return seed;
+}
+
+net::dns_cache::dns_cache()
+    : dns_cache(options {})
+{
+}
+
+net::dns_cache::dns_cache(options opts)
+    : m_options { opts }
+{
+    for (shard& s : m_shards)
+        s.entries = std::make_shared<const table>();
+    m_refresher = std::thread(&dns_cache::refresh_loop, this);
+}
+
+net::dns_cache::~dns_cache()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_refresh_mutex);
+        m_stopping = true;
+    }
+    m_refresh_wakeup.notify_one();
+    m_refresher.join();
+}
+
+net::dns_cache::result net::dns_cache::resolve(std::string_view host, std::string_view service, int family, int type, int protocol, int flags)
+{
+    std::error_code e;
+    result addresses = resolve(host, service, family, type, protocol, flags, e);
+    THROW_IF_ERROR(e);
+    return addresses;
+}
+
+net::dns_cache::result net::dns_cache::resolve(std::string_view host, std::string_view service, int family, int type, int protocol, int flags, std::error_code& e)
+{
+    // reused, so that hits don't allocate once its strings grew enough
+    thread_local key probe;
+    probe.host.assign(host);
+    probe.service.assign(service);
+    probe.family = family;
+    probe.type = type;
+    probe.protocol = protocol;
+    probe.flags = flags;
+
+    entry_ptr found = lookup(probe);
+    e = found->error;
+    return found->addresses;
+}
+
+net::dns_cache::shard& net::dns_cache::shard_of(const key& k) noexcept
+{
+    return m_shards[key_hash {}(k) % shard_count];
+}
+
+net::dns_cache::entry_ptr net::dns_cache::lookup(const key& k)
+{
+    std::shared_ptr<const table> snapshot = std::atomic_load(&shard_of(k).entries);
+    auto it = snapshot->find(k);
+    if (it != snapshot->end()) {
+        const entry_ptr& found = it->second;
+        auto now = clock::now();
+        if (now < found->expires) {
+            if (found->addresses && now >= found->refresh_at && !found->refreshing.exchange(true, std::memory_order_relaxed))
+                schedule_refresh(k);
+            return found;
+        }
+    }
+
+    // missed or expired, the first caller resolves and the others wait for it
+    std::unique_lock<std::mutex> lock(m_mutex);
+    auto flight = m_in_flight.find(k);
+    if (flight != m_in_flight.end()) {
+        std::shared_future<entry_ptr> pending = flight->second;
+        lock.unlock();
+        return pending.get();
+    }
+    std::promise<entry_ptr> promise;
+    m_in_flight.emplace(k, promise.get_future().share());
+    lock.unlock();
+
+    entry_ptr fetched;
+    try {
+        fetched = fetch(k);
+        publish(k, fetched);
+    } catch (...) {
+        lock.lock();
+        m_in_flight.erase(k);
+        lock.unlock();
+        promise.set_exception(std::current_exception());
+        throw;
+    }
+
+    lock.lock();
+    m_in_flight.erase(k);
+    lock.unlock();
+    promise.set_value(fetched);
+    return fetched;
+}
+
+net::dns_cache::entry_ptr net::dns_cache::fetch(const key& k)
+{
+    std::vector<address_info> found;
+    std::error_code error;
+    getaddrinfo(std::back_inserter(found), k.host.empty() ? nullptr : k.host.c_str(), k.service.empty() ? nullptr : k.service.c_str(),
+        k.family, k.type, k.protocol, k.flags, error);
+
+    auto fetched = std::make_shared<entry>();
+    auto now = clock::now();
+    if (error) {
+        fetched->error = error;
+        // only the answers of the resolver are worth remembering, not EAI_SYSTEM failures
+        fetched->expires = error.category() == addrinfo_category() ? now + m_options.negative_ttl : now;
+        fetched->refresh_at = fetched->expires;
+    } else {
+        fetched->addresses = std::make_shared<const std::vector<address_info>>(std::move(found));
+        fetched->expires = now + m_options.ttl;
+        fetched->refresh_at = fetched->expires - std::min(m_options.refresh_ahead, m_options.ttl / 2);
+    }
+    return fetched;
+}
+
+void net::dns_cache::publish(const key& k, entry_ptr e)
+{
+    if (e->expires <= clock::now())
+        return;
+
+    shard& target = shard_of(k);
+    std::size_t limit = std::max<std::size_t>((m_options.max_entries + shard_count - 1) / shard_count, 1);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto updated = std::make_shared<table>(*std::atomic_load(&target.entries));
+    if (updated->size() >= limit && !updated->count(k)) {
+        auto now = clock::now();
+        for (auto it = updated->begin(); it != updated->end();) {
+            if (it->second->expires <= now)
+                it = updated->erase(it);
+            else
+                ++it;
+        }
+        if (updated->size() >= limit && !updated->empty())
+            updated->erase(updated->begin());
+    }
+    (*updated)[k] = std::move(e);
+    std::atomic_store(&target.entries, std::shared_ptr<const table>(std::move(updated)));
+}
+
+void net::dns_cache::schedule_refresh(const key& k)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_refresh_mutex);
+        m_refresh_queue.push_back(k);
+    }
+    m_refresh_wakeup.notify_one();
+}
+
+void net::dns_cache::refresh_loop()
+{
+    std::unique_lock<std::mutex> lock(m_refresh_mutex);
+    for (;;) {
+        m_refresh_wakeup.wait(lock, [this] { return m_stopping || !m_refresh_queue.empty(); });
+        if (m_stopping)
+            return;
+        std::vector<key> keys;
+        keys.swap(m_refresh_queue);
+        lock.unlock();
+
+        for (const key& k : keys) {
+            try {
+                entry_ptr fetched = fetch(k);
+                // on failures the current answer is kept until it expires
+                if (fetched->error)
+                    continue;
+                // unless clear() dropped it meanwhile
+                if (std::atomic_load(&shard_of(k).entries)->count(k))
+                    publish(k, std::move(fetched));
+            } catch (const std::bad_alloc&) {
+            }
+        }
+        lock.lock();
+    }
+}
+
+void net::dns_cache::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (shard& s : m_shards)
+        std::atomic_store(&s.entries, std::make_shared<const table>());
+}
+
+std::size_t net::dns_cache::size() const
+{
+    std::size_t total = 0;
+    for (const shard& s : m_shards)
+        total += std::atomic_load(&s.entries)->size();
+    return total;
+}
@@ -0,0 +1,78 @@
+#include <cppnet/endpoint.hpp>
+
+#include <ostream>
+
+#ifdef _WIN32
+#include <ws2tcpip.h>
+#endif
+
+namespace {
+
+// splitmix64 finalizer, as for net::address
+std::uint64_t mix(std::uint64_t x) noexcept
+{
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebull;
+    x ^= x >> 31;
+    return x;
+}
+
+std::uint64_t load(const std::uint8_t* bytes, std::size_t size) noexcept
+{
+    std::uint64_t word = 0;
+    std::memcpy(&word, bytes, size);
+    return word;
+}
+
+}
+
+net::endpoint_v4::endpoint_v4(const address& addr)
+{
+    if (addr.family() != AF_INET)
+        throw std::invalid_argument("the address is not an IPv4 address");
+    *this = endpoint_v4 { *reinterpret_cast<const sockaddr_in*>(addr.address_pointer()) };
+}
+
+net::address net::endpoint_v4::to_address() const noexcept
+{
+    sockaddr_in addr = native();
+    return { reinterpret_cast<const sockaddr*>(&addr), sizeof(addr) };
+}
+
+net::endpoint_v6::endpoint_v6(const address& addr)
+{
+    if (addr.family() != AF_INET6)
+        throw std::invalid_argument("the address is not an IPv6 address");
+    *this = endpoint_v6 { *reinterpret_cast<const sockaddr_in6*>(addr.address_pointer()) };
+}
+
+net::address net::endpoint_v6::to_address() const noexcept
+{
+    sockaddr_in6 addr = native();
+    return { reinterpret_cast<const sockaddr*>(&addr), sizeof(addr) };
+}
+
+std::ostream& net::operator<<(std::ostream& os, const endpoint_v4& endpoint)
+{
+    return os << endpoint.to_address();
+}
+
+std::ostream& net::operator<<(std::ostream& os, const endpoint_v6& endpoint)
+{
+    return os << endpoint.to_address();
+}
+
+std::size_t std::hash<net::endpoint_v4>::operator()(const net::endpoint_v4& endpoint) const noexcept
+{
+    return static_cast<std::size_t>(mix(load(endpoint.data(), endpoint.size())));
+}
+
+std::size_t std::hash<net::endpoint_v6>::operator()(const net::endpoint_v6& endpoint) const noexcept
+{
+    const std::uint8_t* bytes = endpoint.data();
+    std::uint64_t h = mix(load(bytes, 8));
+    h = mix(h ^ load(bytes + 8, 8));
+    return static_cast<std::size_t>(mix(h ^ load(bytes + 16, 6)));
+}
@@ -1,7 +1,23 @@
 #ifdef __linux__
 #include <cppnet/epoll.hpp>
+#include <sys/ioctl.h>
 #include <unistd.h>
 
+#ifndef EPIOCSPARAMS // linux/eventpoll.h since 6.9
+struct epoll_params {
+    std::uint32_t busy_poll_usecs;
+    std::uint16_t busy_poll_budget;
+    std::uint8_t prefer_busy_poll;
+    std::uint8_t pad;
+};
+#define EPIOCSPARAMS _IOW(0x8A, 0x01, struct epoll_params)
+#define EPIOCGPARAMS _IOR(0x8A, 0x02, struct epoll_params)
+#endif
+
+#define THROW_IF_ERROR(e) \
+    if (e)                \
+    throw std::system_error(e)
+
 net::epoll::epoll()
     : epoll(0) // can throw
 {
@@ -25,6 +41,14 @@ net::epoll::epoll(int flags, std::error_code& e) noexcept
 
 net::epoll::epoll(net::epoll&& rhs) noexcept
     : m_handle(rhs.m_handle)
+    , registered(std::move(rhs.registered))
+    , size(std::exchange(rhs.size, 0))
+    , m_spin(rhs.m_spin)
+    , m_spin_stats(rhs.m_spin_stats)
+    , m_changes(std::move(rhs.m_changes))
+    , m_change_slots(std::move(rhs.m_change_slots))
+    , m_change_errors(std::move(rhs.m_change_errors))
+    , m_change_stats(rhs.m_change_stats)
 {
     rhs.m_handle = -1;
 }
@@ -39,11 +63,36 @@ net::epoll::~epoll() noexcept
 net::epoll& net::epoll::operator=(net::epoll&& rhs) noexcept
 {
     m_handle = std::exchange(rhs.m_handle, -1);
+    registered = std::move(rhs.registered);
+    size = std::exchange(rhs.size, 0);
+    m_spin = rhs.m_spin;
+    m_spin_stats = rhs.m_spin_stats;
+    m_changes = std::move(rhs.m_changes);
+    m_change_slots = std::move(rhs.m_change_slots);
+    m_change_errors = std::move(rhs.m_change_errors);
+    m_change_stats = rhs.m_change_stats;
     return *this;
 }
 
+void net::epoll::track(socket::native_handle_type fd, bool active) noexcept
+{
+    if (fd < 0)
+        return;
+    if (static_cast<std::size_t>(fd) >= registered.size()) {
+        if (!active)
+            return;
+        try {
+            registered.resize(fd + 1);
+        } catch (const std::bad_alloc&) {
+            return; // the registry is only used for handles(), don't fail the add because of it
+        }
+    }
+    registered[fd] = active;
+}
+
 bool net::epoll::add(socket::native_handle_type fd, int events) noexcept
 {
+    forget_change(fd);
     epoll_event event{};
     event.events = events;
     event.data.fd = fd;
@@ -53,12 +102,14 @@ bool net::epoll::add(socket::native_handle_type fd, int events) noexcept
         return false;
     else {
         ++size;
+        track(fd, true);
         return true;
     }
 }
 
 bool net::epoll::add(socket::native_handle_type fd, int events, std::error_code& e) noexcept
 {
+    forget_change(fd);
     epoll_event event;
     event.events = events;
     event.data.fd = fd;
@@ -71,12 +122,14 @@ bool net::epoll::add(socket::native_handle_type fd, int events, std::error_code&
     } else {
         e.assign(0, std::system_category());
         ++size;
+        track(fd, true);
         return true;
     }
 }
 
 bool net::epoll::modify(socket::native_handle_type fd, int events) noexcept
 {
+    forget_change(fd);
     epoll_event event;
     event.events = events;
     event.data.fd = fd;
@@ -86,6 +139,7 @@ bool net::epoll::modify(socket::native_handle_type fd, int events) noexcept
 
 bool net::epoll::modify(socket::native_handle_type fd, int events, std::error_code& e) noexcept
 {
+    forget_change(fd);
     epoll_event event;
     event.events = events;
     event.data.fd = fd;
@@ -103,17 +157,20 @@ bool net::epoll::modify(socket::native_handle_type fd, int events, std::error_co
 
 bool net::epoll::remove(socket::native_handle_type fd) noexcept
 {
+    forget_change(fd);
     int ret = epoll_ctl(m_handle, EPOLL_CTL_DEL, fd, nullptr);
     if (ret < 0)
         return false;
     else {
         --size;
+        track(fd, false);
         return true;
     }
 }
 
 bool net::epoll::remove(socket::native_handle_type fd, std::error_code& e) noexcept
 {
+    forget_change(fd);
     int ret = epoll_ctl(m_handle, EPOLL_CTL_DEL, fd, nullptr);
 
     if (ret < 0) {
@@ -122,8 +179,118 @@ bool net::epoll::remove(socket::native_handle_type fd, std::error_code& e) noexc
     } else {
         e.assign(0, std::system_category());
         --size;
+        track(fd, false);
+        return true;
+    }
+}
+
+void net::epoll::defer_add(socket::native_handle_type fd, int events)
+{
+    defer(fd, change_op::add, events);
+}
+
+void net::epoll::defer_modify(socket::native_handle_type fd, int events)
+{
+    defer(fd, change_op::modify, events);
+}
+
+void net::epoll::defer_remove(socket::native_handle_type fd)
+{
+    defer(fd, change_op::remove, 0);
+}
+
+void net::epoll::defer(socket::native_handle_type fd, change_op op, int events)
+{
+    ++m_change_stats.recorded;
+    std::size_t slot = fd >= 0 && static_cast<std::size_t>(fd) < m_change_slots.size() ? m_change_slots[fd] : 0;
+    if (slot) {
+        change& pending = m_changes[slot - 1];
+        switch (pending.op) {
+        case change_op::none:
+            pending.op = op;
+            pending.readd = false;
+            break;
+        case change_op::add:
+            if (op == change_op::remove)
+                pending.op = change_op::none;
+            break;
+        case change_op::modify:
+            if (op == change_op::remove)
+                pending.op = change_op::remove;
+            break;
+        case change_op::remove:
+            if (op != change_op::add)
+                return; // modifying what's removed
+            pending.op = change_op::modify;
+            pending.readd = true;
+            break;
+        }
+        pending.events = events;
+        ++m_change_stats.collapsed;
+        return;
+    }
+
+    if (fd >= 0 && static_cast<std::size_t>(fd) >= m_change_slots.size())
+        m_change_slots.resize(fd + 1);
+    m_changes.push_back({ fd, events, op });
+    m_change_errors.reserve(m_changes.size()); // apply_changes() doesn't allocate
+    if (fd >= 0)
+        m_change_slots[fd] = m_changes.size();
+}
+
+void net::epoll::forget_change(socket::native_handle_type fd) noexcept
+{
+    if (fd < 0 || static_cast<std::size_t>(fd) >= m_change_slots.size() || !m_change_slots[fd])
+        return;
+    m_changes[m_change_slots[fd] - 1].op = change_op::none;
+    m_change_slots[fd] = 0;
+}
+
+std::size_t net::epoll::apply_changes() noexcept
+{
+    m_change_errors.clear();
+    std::size_t calls = 0;
+    // a descriptor closed since it was added is gone from the set, take it off the count too
+    auto forget_closed = [this](socket::native_handle_type fd) noexcept {
+        if (static_cast<std::size_t>(fd) >= registered.size() || !registered[fd])
+            return false;
+        --size;
+        track(fd, false);
         return true;
+    };
+    for (const change& c : m_changes) {
+        if (c.fd >= 0)
+            m_change_slots[c.fd] = 0;
+        std::error_code e;
+        switch (c.op) {
+        case change_op::none:
+            continue;
+        case change_op::add:
+            add(c.fd, c.events, e);
+            break;
+        case change_op::modify:
+            // from a remove then an add, the descriptor may have been closed in between
+            if (!modify(c.fd, c.events, e) && (e == std::errc::bad_file_descriptor || e == std::errc::no_such_file_or_directory)) {
+                forget_closed(c.fd);
+                if (c.readd && e == std::errc::no_such_file_or_directory) {
+                    ++calls;
+                    add(c.fd, c.events, e);
+                }
+            }
+            break;
+        case change_op::remove:
+            if (!remove(c.fd, e) && (e == std::errc::bad_file_descriptor || e == std::errc::no_such_file_or_directory)
+                && forget_closed(c.fd))
+                e.clear();
+            break;
+        }
+        ++calls;
+        if (e)
+            m_change_errors.emplace_back(c.fd, e);
     }
+    m_changes.clear();
+    m_change_stats.applied += calls;
+    return calls;
 }
 
 size_t net::epoll::execute(std::optional<std::chrono::milliseconds> timeout)
@@ -136,9 +303,7 @@ size_t net::epoll::execute(std::optional<std::chrono::milliseconds> timeout)
 
 size_t net::epoll::execute(std::optional<std::chrono::milliseconds> timeout, std::error_code& e)
 {
-    data.clear();
-    data.resize(size);
-    int ret = epoll_wait(m_handle, data.data(), size, timeout ? timeout->count() : -1);
+    int ret = wait(timeout, nullptr);
     if (ret < 0) {
         e.assign(errno, std::system_category());
         return 0;
@@ -158,9 +323,7 @@ size_t net::epoll::execute(std::optional<std::chrono::milliseconds> timeout, con
 
 size_t net::epoll::execute(std::optional<std::chrono::milliseconds> timeout, const sigset_t& sigmask, std::error_code& e)
 {
-    data.clear();
-    data.resize(size);
-    int ret = epoll_pwait(m_handle, data.data(), size, timeout ? timeout->count() : -1, &sigmask);
+    int ret = wait(timeout, &sigmask);
     if (ret < 0) {
         e.assign(errno, std::system_category());
         return 0;
@@ -170,6 +333,102 @@ size_t net::epoll::execute(std::optional<std::chrono::milliseconds> timeout, con
     }
 }
 
+int net::epoll::wait(std::optional<std::chrono::milliseconds> timeout, const sigset_t* sigmask) noexcept
+{
+    if (!m_changes.empty())
+        apply_changes();
+
+    auto poll = [&](int milliseconds) {
+        data.clear();
+        data.resize(size);
+        int ret = sigmask ? epoll_pwait(m_handle, data.data(), size, milliseconds, sigmask)
+                          : epoll_wait(m_handle, data.data(), size, milliseconds);
+        data.resize(ret > 0 ? ret : 0); // get() reports only what happened
+        return ret;
+    };
+
+    if (m_spin.count() > 0 && timeout != std::chrono::milliseconds::zero()) {
+        auto start = std::chrono::steady_clock::now();
+        auto deadline = start + m_spin;
+        if (timeout && start + *timeout < deadline)
+            deadline = start + *timeout;
+
+        int ret = 0;
+        auto now = start;
+        while (ret == 0 && now < deadline) {
+            ret = poll(0);
+            ++m_spin_stats.polls;
+            now = std::chrono::steady_clock::now();
+        }
+        m_spin_stats.spinning += now - start;
+        if (ret != 0) {
+            if (ret > 0)
+                ++m_spin_stats.spun;
+            return ret;
+        }
+        if (timeout) {
+            // what's left of it, with the time spent rounded down: a timeout isn't cut short by the
+            // spin, at the cost of waiting less than a millisecond longer than asked
+            auto spent = std::chrono::floor<std::chrono::milliseconds>(now - start);
+            timeout = spent < *timeout ? *timeout - spent : std::chrono::milliseconds::zero();
+            if (*timeout == std::chrono::milliseconds::zero())
+                return 0;
+        }
+    }
+
+    if (timeout != std::chrono::milliseconds::zero())
+        ++m_spin_stats.slept;
+    return poll(timeout ? static_cast<int>(timeout->count()) : -1);
+}
+
+void net::epoll::set_spin(std::chrono::microseconds budget) noexcept
+{
+    m_spin = budget;
+}
+
+void net::epoll::set_busy_poll(const busy_poll_parameters& params)
+{
+    std::error_code e;
+    set_busy_poll(params, e);
+    THROW_IF_ERROR(e);
+}
+
+void net::epoll::set_busy_poll(const busy_poll_parameters& params, std::error_code& e) noexcept
+{
+    epoll_params native {};
+    native.busy_poll_usecs = static_cast<std::uint32_t>(params.usecs.count());
+    native.busy_poll_budget = params.budget;
+    native.prefer_busy_poll = params.prefer;
+    if (ioctl(m_handle, EPIOCSPARAMS, &native) < 0)
+        e.assign(errno == ENOTTY ? EOPNOTSUPP : errno, std::system_category());
+    else
+        e.assign(0, std::system_category());
+}
+
+net::epoll::busy_poll_parameters net::epoll::busy_poll() const
+{
+    std::error_code e;
+    busy_poll_parameters params = busy_poll(e);
+    THROW_IF_ERROR(e);
+    return params;
+}
+
+net::epoll::busy_poll_parameters net::epoll::busy_poll(std::error_code& e) const noexcept
+{
+    epoll_params native {};
+    if (ioctl(m_handle, EPIOCGPARAMS, &native) < 0) {
+        e.assign(errno == ENOTTY ? EOPNOTSUPP : errno, std::system_category());
+        return {};
+    }
+    e.assign(0, std::system_category());
+    return { std::chrono::microseconds { native.busy_poll_usecs }, native.busy_poll_budget, native.prefer_busy_poll != 0 };
+}
+
+net::epoll::native_handle_type net::epoll::native_handle() const noexcept
+{
+    return m_handle;
+}
+
 void net::epoll::close()
 {
     if (::close(m_handle) < 0) {
@@ -189,4 +448,42 @@ void net::epoll::close(std::error_code& e) noexcept
     }
 }
 
+void net::set_busy_poll(socket& sock, std::chrono::microseconds usecs)
+{
+    std::error_code e;
+    set_busy_poll(sock, usecs, e);
+    THROW_IF_ERROR(e);
+}
+
+void net::set_busy_poll(socket& sock, std::chrono::microseconds usecs, std::error_code& e) noexcept
+{
+    int value = static_cast<int>(usecs.count());
+    sock.setsockopt(SOL_SOCKET, SO_BUSY_POLL, &value, sizeof(value), e);
+}
+
+void net::set_prefer_busy_poll(socket& sock, bool prefer)
+{
+    std::error_code e;
+    set_prefer_busy_poll(sock, prefer, e);
+    THROW_IF_ERROR(e);
+}
+
+void net::set_prefer_busy_poll(socket& sock, bool prefer, std::error_code& e) noexcept
+{
+    int value = prefer;
+    sock.setsockopt(SOL_SOCKET, SO_PREFER_BUSY_POLL, &value, sizeof(value), e);
+}
+
+void net::set_busy_poll_budget(socket& sock, int budget)
+{
+    std::error_code e;
+    set_busy_poll_budget(sock, budget, e);
+    THROW_IF_ERROR(e);
+}
+
+void net::set_busy_poll_budget(socket& sock, int budget, std::error_code& e) noexcept
+{
+    sock.setsockopt(SOL_SOCKET, SO_BUSY_POLL_BUDGET, &budget, sizeof(budget), e);
+}
+
 #endif
@@ -0,0 +1,309 @@
+#ifdef __linux__
+#include <cppnet/executor.hpp>
+
+#include <algorithm>
+
+#include <pthread.h>
+#include <sched.h>
+
+namespace {
+
+thread_local const net::executor* current_executor = nullptr;
+thread_local std::size_t current_index = 0;
+
+}
+
+net::detail::work_deque::work_deque(std::size_t capacity)
+{
+    std::size_t size = 2;
+    while (size < capacity)
+        size *= 2;
+    m_rings.push_back(std::make_unique<ring>(size));
+    m_ring.store(m_rings.back().get(), std::memory_order_relaxed);
+}
+
+net::detail::work_deque::ring* net::detail::work_deque::grow(ring* old, std::int64_t bottom, std::int64_t top)
+{
+    auto bigger = std::make_unique<ring>(2 * (old->mask + 1));
+    for (std::int64_t i = top; i < bottom; ++i) {
+        job* j = old->slots[static_cast<std::size_t>(i) & old->mask].load(std::memory_order_relaxed);
+        bigger->slots[static_cast<std::size_t>(i) & bigger->mask].store(j, std::memory_order_relaxed);
+    }
+    m_rings.push_back(std::move(bigger));
+    ring* r = m_rings.back().get();
+    m_ring.store(r, std::memory_order_release);
+    return r;
+}
+
+void net::detail::work_deque::push(job* j)
+{
+    std::int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+    std::int64_t top = m_top.load(std::memory_order_acquire);
+    ring* r = m_ring.load(std::memory_order_relaxed);
+    if (bottom - top > static_cast<std::int64_t>(r->mask))
+        r = grow(r, bottom, top);
+    r->slots[static_cast<std::size_t>(bottom) & r->mask].store(j, std::memory_order_release);
+    m_bottom.store(bottom + 1, std::memory_order_release);
+}
+
+net::detail::job* net::detail::work_deque::take() noexcept
+{
+    std::int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+    ring* r = m_ring.load(std::memory_order_relaxed);
+    m_bottom.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::int64_t top = m_top.load(std::memory_order_relaxed);
+
+    if (top > bottom) {
+        m_bottom.store(bottom + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    job* j = r->slots[static_cast<std::size_t>(bottom) & r->mask].load(std::memory_order_relaxed);
+    if (top == bottom) {
+        // the last one, a thief may be taking it too
+        if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            j = nullptr;
+        m_bottom.store(bottom + 1, std::memory_order_relaxed);
+    }
+    return j;
+}
+
+net::detail::job* net::detail::work_deque::steal() noexcept
+{
+    std::int64_t top = m_top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::int64_t bottom = m_bottom.load(std::memory_order_acquire);
+    if (top >= bottom)
+        return nullptr;
+
+    ring* r = m_ring.load(std::memory_order_acquire);
+    job* j = r->slots[static_cast<std::size_t>(top) & r->mask].load(std::memory_order_acquire);
+    if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        return nullptr;
+    return j;
+}
+
+net::detail::job* net::detail::inbox::take_all() noexcept
+{
+    job* newest = m_head.exchange(nullptr, std::memory_order_acquire);
+    job* oldest = nullptr;
+    while (newest) {
+        job* next = newest->next;
+        newest->next = oldest;
+        oldest = newest;
+        newest = next;
+    }
+    return oldest;
+}
+
+net::executor::executor()
+    : executor(options {})
+{
+}
+
+net::executor::executor(options opts)
+{
+    std::size_t count = std::max<std::size_t>(opts.threads, 1);
+    for (std::size_t i = 0; i < count; ++i)
+        m_workers.push_back(std::make_unique<worker>(opts.deque_capacity));
+
+    // nearest first: i + 1, i - 1, i + 2, i - 2...
+    for (std::size_t i = 0; i < count; ++i) {
+        std::vector<std::size_t>& victims = m_workers[i]->victims;
+        for (std::size_t distance = 1; victims.size() + 1 < count; ++distance) {
+            std::size_t after = (i + distance) % count;
+            std::size_t before = (i + count - distance % count) % count;
+            if (std::find(victims.begin(), victims.end(), after) == victims.end() && after != i)
+                victims.push_back(after);
+            if (std::find(victims.begin(), victims.end(), before) == victims.end() && before != i)
+                victims.push_back(before);
+        }
+    }
+
+    std::vector<int> cpus;
+    if (opts.pin) {
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+            for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+                if (CPU_ISSET(cpu, &allowed))
+                    cpus.push_back(cpu);
+            }
+        }
+    }
+
+    for (std::size_t i = 0; i < count; ++i) {
+        m_workers[i]->thread = std::thread(&executor::run, this, i);
+        if (!cpus.empty()) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpus[i % cpus.size()], &set);
+            pthread_setaffinity_np(m_workers[i]->thread.native_handle(), sizeof(set), &set); // a hint, failing is harmless
+        }
+    }
+}
+
+net::executor::~executor()
+{
+    m_stopping.store(true);
+    for (auto& w : m_workers) {
+        std::lock_guard lock { w->mutex };
+        w->wakeup.notify_one();
+    }
+    for (auto& w : m_workers)
+        w->thread.join();
+}
+
+void net::executor::submit(task t)
+{
+    auto* j = new detail::job { std::move(t) };
+    if (current_executor == this)
+        m_workers[current_index]->deque.push(j);
+    else
+        m_injector.push(j);
+    wake_any();
+}
+
+void net::executor::submit(task t, std::size_t hint)
+{
+    auto* j = new detail::job { std::move(t) };
+    std::size_t index = hint % m_workers.size();
+    if (current_executor == this && current_index == index) {
+        // this worker is busy with the caller's task, an idle one may steal it meanwhile
+        m_workers[index]->deque.push(j);
+        wake_any();
+        return;
+    }
+    m_workers[index]->inbox.push(j);
+    // a busy worker won't look at its inbox before its task is done, an idle one takes it over
+    if (!wake(*m_workers[index]))
+        wake_any();
+}
+
+std::size_t net::executor::current_worker() const noexcept
+{
+    return current_executor == this ? current_index : m_workers.size();
+}
+
+net::executor::statistics net::executor::stats() const noexcept
+{
+    statistics total {};
+    for (const auto& w : m_workers) {
+        total.executed += w->executed.load(std::memory_order_relaxed);
+        total.stolen += w->stolen.load(std::memory_order_relaxed);
+        total.parked += w->parked.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+void net::executor::run(std::size_t index)
+{
+    current_executor = this;
+    current_index = index;
+    worker& self = *m_workers[index];
+
+    for (;;) {
+        if (detail::job* j = find_work(self)) {
+            j->run();
+            delete j;
+            self.executed.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        std::unique_lock lock { self.mutex };
+        self.sleeping.store(true);
+        m_sleepers.fetch_add(1);
+        // submitters look at sleeping after they queued their job, this looks for jobs after
+        // sleeping is set: either sees the other
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        bool idle = !has_work(self);
+        if (idle && m_stopping.load())
+            break;
+        if (idle) {
+            self.parked.fetch_add(1, std::memory_order_relaxed);
+            self.wakeup.wait(lock);
+        }
+        self.sleeping.store(false, std::memory_order_relaxed);
+        m_sleepers.fetch_sub(1);
+    }
+    self.sleeping.store(false, std::memory_order_relaxed);
+    m_sleepers.fetch_sub(1);
+}
+
+net::detail::job* net::executor::find_work(worker& self)
+{
+    // the first of the jobs taken from an inbox is run, the others go to the deque to be stolen
+    auto adopt = [&](detail::job* list) -> detail::job* {
+        if (!list)
+            return nullptr;
+        detail::job* next = list->next;
+        if (next) {
+            for (detail::job* j = next; j;) {
+                detail::job* following = j->next;
+                self.deque.push(j);
+                j = following;
+            }
+            wake_any();
+        }
+        return list;
+    };
+
+    if (detail::job* j = self.deque.take())
+        return j;
+    if (detail::job* j = adopt(self.inbox.take_all()))
+        return j;
+    if (detail::job* j = adopt(m_injector.take_all()))
+        return j;
+
+    for (std::size_t victim : self.victims) {
+        if (detail::job* j = m_workers[victim]->deque.steal()) {
+            self.stolen.fetch_add(1, std::memory_order_relaxed);
+            return j;
+        }
+    }
+    // the inboxes of the workers too busy to look at them
+    for (std::size_t victim : self.victims) {
+        if (detail::job* j = adopt(m_workers[victim]->inbox.take_all())) {
+            self.stolen.fetch_add(1, std::memory_order_relaxed);
+            return j;
+        }
+    }
+    return nullptr;
+}
+
+bool net::executor::has_work(const worker& self) const noexcept
+{
+    if (!self.deque.empty() || !self.inbox.empty() || !m_injector.empty())
+        return true;
+    for (std::size_t victim : self.victims) {
+        if (!m_workers[victim]->deque.empty() || !m_workers[victim]->inbox.empty())
+            return true;
+    }
+    return false;
+}
+
+bool net::executor::wake(worker& w)
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!w.sleeping.load())
+        return false;
+    std::lock_guard lock { w.mutex };
+    w.wakeup.notify_one();
+    return true;
+}
+
+void net::executor::wake_any()
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_sleepers.load() == 0)
+        return;
+    for (auto& w : m_workers) {
+        if (w->sleeping.load()) {
+            std::lock_guard lock { w->mutex };
+            w->wakeup.notify_one();
+            return;
+        }
+    }
+}
+
+#endif
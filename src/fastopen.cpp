@@ -0,0 +1,69 @@
+#ifdef __linux__
+#include <cppnet/fastopen.hpp>
+
+#define THROW_IF_ERROR(e) \
+    if (e)                \
+    throw std::system_error(e)
+
+void net::listen_fastopen(socket& sock, int backlog, int queue_length)
+{
+    std::error_code e;
+    listen_fastopen(sock, backlog, queue_length, e);
+    THROW_IF_ERROR(e);
+}
+
+void net::listen_fastopen(socket& sock, int backlog, int queue_length, std::error_code& e) noexcept
+{
+    sock.setsockopt(IPPROTO_TCP, TCP_FASTOPEN, &queue_length, sizeof(queue_length), e);
+    if (e)
+        return;
+    sock.listen(backlog, e);
+}
+
+void net::set_fastopen_key(socket& sock, const fastopen_key& key)
+{
+    std::error_code e;
+    set_fastopen_key(sock, key, e);
+    THROW_IF_ERROR(e);
+}
+
+void net::set_fastopen_key(socket& sock, const fastopen_key& key, std::error_code& e) noexcept
+{
+    sock.setsockopt(IPPROTO_TCP, TCP_FASTOPEN_KEY, key.data(), key.size(), e);
+}
+
+size_t net::connect_fastopen(socket& sock, const address& addr, const void* data, size_t size, int flags)
+{
+    std::error_code e;
+    size_t sent = connect_fastopen(sock, addr, data, size, flags, e);
+    THROW_IF_ERROR(e);
+    return sent;
+}
+
+size_t net::connect_fastopen(socket& sock, const address& addr, const void* data, size_t size, int flags, std::error_code& e) noexcept
+{
+    size_t sent = sock.sendto(data, size, flags | MSG_FASTOPEN, addr, e);
+    if (e != std::errc::operation_not_supported)
+        return e ? 0 : sent;
+
+    // client Fast Open is disabled in the kernel
+    sock.connect(addr, e);
+    if (e)
+        return 0;
+    return sock.send(data, size, flags, e);
+}
+
+void net::enable_fastopen_connect(socket& sock)
+{
+    std::error_code e;
+    enable_fastopen_connect(sock, e);
+    THROW_IF_ERROR(e);
+}
+
+void net::enable_fastopen_connect(socket& sock, std::error_code& e) noexcept
+{
+    int enable = 1;
+    sock.setsockopt(IPPROTO_TCP, TCP_FASTOPEN_CONNECT, &enable, sizeof(enable), e);
+}
+
+#endif
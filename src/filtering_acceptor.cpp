@@ -0,0 +1,160 @@
+#include <cppnet/filtering_acceptor.hpp>
+
+#define THROW_IF_ERROR(e) \
+    if (e)                \
+    throw std::system_error(e)
+
+#ifdef _WIN32
+#include <ws2tcpip.h>
+#endif
+
+namespace {
+
+// IPv4 peers of dual stack listeners come as ::ffff:a.b.c.d, they're matched against the IPv4 rules
+net::address unmapped(const net::address& peer) noexcept
+{
+    if (peer.family() != AF_INET6)
+        return peer;
+    auto in6 = reinterpret_cast<const sockaddr_in6*>(peer.address_pointer());
+    if (!IN6_IS_ADDR_V4MAPPED(&in6->sin6_addr))
+        return peer;
+    sockaddr_in in {};
+    in.sin_family = AF_INET;
+    in.sin_port = in6->sin6_port;
+    std::memcpy(&in.sin_addr, reinterpret_cast<const std::uint8_t*>(&in6->sin6_addr) + 12, 4);
+    return { reinterpret_cast<const sockaddr*>(&in), sizeof(in) };
+}
+
+}
+
+net::filtering_acceptor::filtering_acceptor(socket& listener, filter_action default_action)
+    : m_listener { listener }
+    , m_default_action { default_action }
+{
+}
+
+void net::filtering_acceptor::add_rule(const ip_prefix& prefix, filter_action action)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::shared_ptr<const table> current = m_table.load();
+    std::shared_ptr<rule_state> existing;
+    current->for_each([&](const ip_prefix& p, const std::shared_ptr<rule_state>& state) {
+        if (p == prefix)
+            existing = state;
+    });
+    if (existing) {
+        existing->action.store(action, std::memory_order_relaxed);
+        return;
+    }
+
+    table updated = *current;
+    updated.insert(prefix, std::make_shared<rule_state>(prefix, action));
+    m_table.store(std::move(updated));
+}
+
+bool net::filtering_acceptor::remove_rule(const ip_prefix& prefix)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::shared_ptr<const table> current = m_table.load();
+
+    // rebuilt rather than erased from, so that removed rules don't leave nodes behind
+    table updated;
+    bool found = false;
+    current->for_each([&](const ip_prefix& p, const std::shared_ptr<rule_state>& state) {
+        if (p == prefix)
+            found = true;
+        else
+            updated.insert(p, state);
+    });
+    if (found)
+        m_table.store(std::move(updated));
+    return found;
+}
+
+void net::filtering_acceptor::set_rules(const std::vector<filter_rule>& rules)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::shared_ptr<const table> current = m_table.load();
+
+    table updated;
+    for (const filter_rule& rule : rules) {
+        std::shared_ptr<rule_state> state;
+        current->for_each([&](const ip_prefix& p, const std::shared_ptr<rule_state>& previous) {
+            if (p == rule.prefix)
+                state = previous;
+        });
+        if (state)
+            state->action.store(rule.action, std::memory_order_relaxed);
+        else
+            state = std::make_shared<rule_state>(rule.prefix, rule.action);
+        updated.insert(rule.prefix, std::move(state));
+    }
+    m_table.store(std::move(updated));
+}
+
+std::vector<net::filter_rule> net::filtering_acceptor::rules() const
+{
+    std::vector<filter_rule> found;
+    m_table.load()->for_each([&](const ip_prefix&, const std::shared_ptr<rule_state>& state) {
+        found.push_back(state->rule());
+    });
+    return found;
+}
+
+net::filter_action net::filtering_acceptor::check(const address& peer) const noexcept
+{
+    std::shared_ptr<const table> snapshot = m_table.load();
+    const std::shared_ptr<rule_state>* matched = snapshot->lookup(unmapped(peer));
+    return matched ? (*matched)->action.load(std::memory_order_relaxed) : m_default_action;
+}
+
+net::socket net::filtering_acceptor::accept(address& peer)
+{
+    std::error_code e;
+    socket accepted = accept(peer, e);
+    THROW_IF_ERROR(e);
+    return accepted;
+}
+
+net::socket net::filtering_acceptor::accept(address& peer, std::error_code& e) noexcept
+{
+    for (;;) {
+        peer = address {}; // accept() shrinks its size to the previous peer's
+        socket accepted = m_listener.accept(peer, e);
+        if (e)
+            return accepted;
+
+        // the rules may change between connections, the latest ones decide
+        std::shared_ptr<const table> snapshot = m_table.load();
+        filter_action action = m_default_action;
+        if (const std::shared_ptr<rule_state>* matched = snapshot->lookup(unmapped(peer))) {
+            (*matched)->hits.fetch_add(1, std::memory_order_relaxed);
+            action = (*matched)->action.load(std::memory_order_relaxed);
+        } else {
+            m_default_hits.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        if (action == filter_action::allow) {
+            m_accepted.fetch_add(1, std::memory_order_relaxed);
+            return accepted;
+        }
+
+        // reset rather than FIN, so that nothing lingers in TIME_WAIT or the send queue
+        m_rejected.fetch_add(1, std::memory_order_relaxed);
+        linger reset {};
+        reset.l_onoff = 1;
+        reset.l_linger = 0;
+        std::error_code ignored;
+        accepted.setsockopt(SOL_SOCKET, SO_LINGER, &reset, sizeof(reset), ignored);
+        accepted.close(ignored);
+    }
+}
+
+std::vector<net::filtering_acceptor::rule_counter> net::filtering_acceptor::counters() const
+{
+    std::vector<rule_counter> found;
+    m_table.load()->for_each([&](const ip_prefix&, const std::shared_ptr<rule_state>& state) {
+        found.push_back({ state->rule(), state->hits.load(std::memory_order_relaxed) });
+    });
+    return found;
+}
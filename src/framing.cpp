@@ -0,0 +1,231 @@
+#include <cppnet/framing.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#define THROW_IF_ERROR(e) \
+    if (e)                \
+    throw std::system_error(e)
+
+namespace {
+
+// IOV_MAX in linux, the usual minimum elsewhere
+constexpr std::size_t max_pieces = 1024;
+
+void check(const net::frame_format& format)
+{
+    if (format.header_size != 2 && format.header_size != 4 && format.header_size != 8)
+        throw std::invalid_argument("frame headers must be 2, 4 or 8 bytes long");
+}
+
+}
+
+void net::encode_frame_header(char* out, std::uint64_t length, const frame_format& format) noexcept
+{
+    std::size_t size = format.header_size;
+    for (std::size_t i = 0; i < size; ++i) {
+        std::size_t shift = 8 * (format.order == byte_order::big ? size - 1 - i : i);
+        out[i] = static_cast<char>(length >> shift);
+    }
+}
+
+std::uint64_t net::decode_frame_header(const char* in, const frame_format& format) noexcept
+{
+    std::size_t size = format.header_size;
+    std::uint64_t length = 0;
+    for (std::size_t i = 0; i < size; ++i) {
+        std::size_t shift = 8 * (format.order == byte_order::big ? size - 1 - i : i);
+        length |= std::uint64_t { static_cast<unsigned char>(in[i]) } << shift;
+    }
+    return length;
+}
+
+net::frame_reader::frame_reader(frame_format format, std::size_t buffer_size)
+    : m_format { format }
+    , m_buffer(std::max(buffer_size, format.header_size))
+{
+    check(format);
+}
+
+std::size_t net::frame_reader::receive(socket& sock, int flags)
+{
+    std::error_code e;
+    std::size_t received = receive(sock, flags, e);
+    THROW_IF_ERROR(e);
+    return received;
+}
+
+std::size_t net::frame_reader::receive(socket& sock, int flags, std::error_code& e)
+{
+    // what's left is the start of a frame
+    if (m_begin) {
+        std::memmove(m_buffer.data(), m_buffer.data() + m_begin, m_end - m_begin);
+        m_end -= m_begin;
+        m_begin = 0;
+    }
+    if (m_end >= m_format.header_size) {
+        std::uint64_t length = decode_frame_header(m_buffer.data(), m_format);
+        if (length <= m_format.max_frame_size && m_format.header_size + length > m_buffer.size())
+            m_buffer.resize(m_format.header_size + static_cast<std::size_t>(length));
+    }
+    if (m_end == m_buffer.size()) {
+        // a frame larger than max_frame_size that wasn't read past
+        e = std::make_error_code(std::errc::message_size);
+        return 0;
+    }
+
+    std::size_t received;
+    do
+        received = sock.recv(m_buffer.data() + m_end, m_buffer.size() - m_end, flags, e);
+    while (e == std::errc::interrupted);
+    if (e)
+        return 0;
+    m_end += received;
+    return received;
+}
+
+bool net::frame_reader::next(std::string_view& frame)
+{
+    std::error_code e;
+    bool found = next(frame, e);
+    THROW_IF_ERROR(e);
+    return found;
+}
+
+bool net::frame_reader::next(std::string_view& frame, std::error_code& e) noexcept
+{
+    e.clear();
+    std::size_t available = m_end - m_begin;
+    if (available < m_format.header_size)
+        return false;
+    const char* start = m_buffer.data() + m_begin;
+    std::uint64_t length = decode_frame_header(start, m_format);
+    if (length > m_format.max_frame_size) {
+        e = std::make_error_code(std::errc::message_size);
+        return false;
+    }
+    if (available - m_format.header_size < length)
+        return false;
+
+    frame = { start + m_format.header_size, static_cast<std::size_t>(length) };
+    m_begin += m_format.header_size + frame.size();
+    // the next receive() won't have to move anything
+    if (m_begin == m_end)
+        m_begin = m_end = 0;
+    return true;
+}
+
+net::frame_writer::frame_writer(frame_format format)
+    : m_format { format }
+{
+    check(format);
+}
+
+void net::frame_writer::push(std::string_view payload)
+{
+    std::error_code e;
+    push(payload, e);
+    THROW_IF_ERROR(e);
+}
+
+void net::frame_writer::push(std::string_view payload, std::error_code& e)
+{
+    if (payload.size() > m_format.max_frame_size) {
+        e = std::make_error_code(std::errc::message_size);
+        return;
+    }
+    e.clear();
+    queued& frame = m_frames.emplace_back();
+    encode_frame_header(frame.header, payload.size(), m_format);
+    frame.payload = payload;
+    m_pending += m_format.header_size + payload.size();
+    // so that flush() doesn't allocate, two pieces per frame, growing geometrically
+    std::size_t needed = std::min(2 * m_frames.size(), max_pieces);
+    if (m_pieces.capacity() < needed)
+        m_pieces.reserve(std::min(std::max(needed, 2 * m_pieces.capacity()), max_pieces));
+}
+
+std::size_t net::frame_writer::flush(socket& sock, int flags)
+{
+    std::error_code e;
+    std::size_t sent = flush(sock, flags, e);
+    THROW_IF_ERROR(e);
+    return sent;
+}
+
+std::size_t net::frame_writer::flush(socket& sock, int flags, std::error_code& e) noexcept
+{
+    e.clear();
+    std::size_t total = 0;
+    const std::size_t header_size = m_format.header_size;
+
+    while (m_first < m_frames.size()) {
+        m_pieces.clear();
+        std::size_t offset = m_offset;
+        for (std::size_t i = m_first; i < m_frames.size() && m_pieces.size() + 2 <= m_pieces.capacity(); ++i) {
+            std::string_view header { m_frames[i].header, header_size };
+            std::string_view payload = m_frames[i].payload;
+            if (offset < header_size)
+                header.remove_prefix(offset);
+            else {
+                payload.remove_prefix(offset - header_size);
+                header = {};
+            }
+            offset = 0;
+#ifdef _WIN32
+            if (!header.empty())
+                m_pieces.push_back({ static_cast<ULONG>(header.size()), const_cast<char*>(header.data()) });
+            if (!payload.empty())
+                m_pieces.push_back({ static_cast<ULONG>(payload.size()), const_cast<char*>(payload.data()) });
+#else
+            if (!header.empty())
+                m_pieces.push_back({ const_cast<char*>(header.data()), header.size() });
+            if (!payload.empty())
+                m_pieces.push_back({ const_cast<char*>(payload.data()), payload.size() });
+#endif
+        }
+
+#ifdef _WIN32
+        DWORD sent = 0;
+        if (::WSASend(sock.native_handle(), m_pieces.data(), static_cast<DWORD>(m_pieces.size()), &sent, static_cast<DWORD>(flags), nullptr, nullptr) != 0)
+            e.assign(::WSAGetLastError(), std::system_category());
+#else
+        msghdr message {};
+        message.msg_iov = m_pieces.data();
+        message.msg_iovlen = m_pieces.size();
+        std::size_t sent = sock.sendmsg(&message, flags, e);
+#endif
+        if (e == std::errc::interrupted) {
+            e.clear();
+            continue;
+        }
+        if (e)
+            break;
+
+        total += sent;
+        m_pending -= sent;
+        while (sent) {
+            std::size_t left = header_size + m_frames[m_first].payload.size() - m_offset;
+            if (sent < left) {
+                m_offset += sent;
+                break;
+            }
+            sent -= left;
+            ++m_first;
+            m_offset = 0;
+        }
+    }
+
+    if (m_first == m_frames.size())
+        clear();
+    return total;
+}
+
+void net::frame_writer::clear() noexcept
+{
+    m_frames.clear();
+    m_first = 0;
+    m_offset = 0;
+    m_pending = 0;
+}
@@ -66,3 +66,41 @@ std::string_view net::address_info::canon_name() const noexcept
 {
     return m_canonname;
 }
+
+net::address_info_list net::getaddrinfo_list(const char* host, const char* service, int family, int type, int protocol, int flags)
+{
+    std::error_code e;
+    address_info_list list = getaddrinfo_list(host, service, family, type, protocol, flags, e);
+    if (e)
+        throw std::system_error(e);
+    return list;
+}
+
+net::address_info_list net::getaddrinfo_list(const char* host, const char* service, int family, int type, int protocol, int flags, std::error_code& e) noexcept
+{
+    ::addrinfo hints {};
+
+    hints.ai_family = family;
+    hints.ai_socktype = type;
+    hints.ai_protocol = protocol;
+    hints.ai_flags = flags;
+
+    ::addrinfo* addrlist = nullptr;
+    int r = ::getaddrinfo(host, service, &hints, &addrlist);
+#ifdef _WIN32
+    if (r != 0) {
+        e.assign(WSAGetLastError(), std::system_category());
+        return {};
+    }
+#else
+    if (r == EAI_SYSTEM) {
+        e.assign(errno, std::system_category());
+        return {};
+    } else if (r != 0) {
+        e.assign(r, addrinfo_category());
+        return {};
+    }
+#endif
+    e.assign(0, std::system_category());
+    return address_info_list { addrlist };
+}
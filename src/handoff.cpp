@@ -0,0 +1,234 @@
+#ifndef _WIN32
+#include <cppnet/handoff.hpp>
+
+#include <cstdint>
+#include <cstring>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define THROW_IF_ERROR(e) \
+    if (e)                \
+    throw std::system_error(e)
+
+namespace {
+
+constexpr char header_magic[4] = { 'C', 'N', 'H', 'O' };
+constexpr char ack_magic[4] = { 'C', 'N', 'H', 'A' };
+constexpr char hello_magic[4] = { 'C', 'N', 'H', 'C' }; // from the successor, once connected
+constexpr std::size_t max_name = 255;
+constexpr std::uint32_t max_sockets = 1024;
+
+#ifdef MSG_NOSIGNAL
+constexpr int send_flags = MSG_NOSIGNAL; // a peer that died mustn't kill the process
+#else
+constexpr int send_flags = 0;
+#endif
+
+struct message_header {
+    char magic[4];
+    std::uint32_t count;
+};
+
+bool valid(const message_header& header, const char (&magic)[4], std::size_t size) noexcept
+{
+    return size == sizeof(header) && std::memcmp(header.magic, magic, sizeof(magic)) == 0;
+}
+
+}
+
+net::socket net::handoff_listen(std::string_view path, int backlog)
+{
+    std::error_code e;
+    socket sock = handoff_listen(path, backlog, e);
+    THROW_IF_ERROR(e);
+    return sock;
+}
+
+net::socket net::handoff_listen(std::string_view path, int backlog, std::error_code& e) noexcept
+{
+    address addr;
+    try {
+        addr = address::from_unix(path);
+    } catch (const std::length_error&) {
+        e = std::make_error_code(std::errc::filename_too_long);
+        return {};
+    }
+
+    // left behind by a process that didn't exit cleanly, it's removed if nothing listens on it,
+    // a running predecessor keeps its channel: its handoff_accept skips the probe, which sends no
+    // hello
+    auto unix_addr = reinterpret_cast<const sockaddr_un*>(addr.address_pointer());
+    struct stat status;
+    if (unix_addr->sun_path[0] != '\0' && ::lstat(unix_addr->sun_path, &status) == 0) {
+        bool stale = false;
+        if (S_ISSOCK(status.st_mode)) {
+            socket probe { AF_UNIX, SOCK_SEQPACKET, 0, e };
+            if (!e)
+                probe.setblocking(false, e);
+            if (!e)
+                probe.connect(addr, e);
+            stale = e == std::errc::connection_refused;
+        }
+        if (!stale) {
+            e = std::make_error_code(std::errc::address_in_use);
+            return {};
+        }
+        ::unlink(unix_addr->sun_path);
+        e.clear();
+    }
+
+    socket sock { AF_UNIX, SOCK_SEQPACKET, 0, e };
+    if (!e)
+        sock.bind(addr, e);
+    if (!e)
+        sock.listen(backlog, e);
+    if (e)
+        return {};
+    return sock;
+}
+
+net::socket net::handoff_connect(std::string_view path)
+{
+    std::error_code e;
+    socket sock = handoff_connect(path, e);
+    THROW_IF_ERROR(e);
+    return sock;
+}
+
+net::socket net::handoff_connect(std::string_view path, std::error_code& e) noexcept
+{
+    address addr;
+    try {
+        addr = address::from_unix(path);
+    } catch (const std::length_error&) {
+        e = std::make_error_code(std::errc::filename_too_long);
+        return {};
+    }
+
+    socket sock { AF_UNIX, SOCK_SEQPACKET, 0, e };
+    if (!e)
+        sock.connect(addr, e);
+    if (e)
+        return {};
+
+    message_header hello {};
+    std::memcpy(hello.magic, hello_magic, sizeof(hello_magic));
+    sock.send(&hello, sizeof(hello), send_flags, e);
+    if (e)
+        return {};
+    return sock;
+}
+
+net::socket net::handoff_accept(socket& server)
+{
+    std::error_code e;
+    socket channel = handoff_accept(server, e);
+    THROW_IF_ERROR(e);
+    return channel;
+}
+
+net::socket net::handoff_accept(socket& server, std::error_code& e) noexcept
+{
+    for (;;) {
+        socket channel = server.accept(e);
+        if (e)
+            return {};
+
+        // what closes without a hello isn't a successor: the probe of handoff_listen, started
+        // by mistake while this process still runs, or a successor that died
+        message_header hello {};
+        std::size_t received = channel.recv(&hello, sizeof(hello), 0, e);
+        if (!e && valid(hello, hello_magic, received))
+            return channel;
+        e.clear();
+    }
+}
+
+void net::send_handoff(socket& channel, const std::vector<std::pair<std::string_view, socket::native_handle_type>>& sockets)
+{
+    std::error_code e;
+    send_handoff(channel, sockets, e);
+    THROW_IF_ERROR(e);
+}
+
+void net::send_handoff(socket& channel, const std::vector<std::pair<std::string_view, socket::native_handle_type>>& sockets, std::error_code& e) noexcept
+{
+    if (sockets.size() > max_sockets) {
+        e = std::make_error_code(std::errc::invalid_argument);
+        return;
+    }
+    message_header header {};
+    std::memcpy(header.magic, header_magic, sizeof(header_magic));
+    header.count = static_cast<std::uint32_t>(sockets.size());
+    channel.send(&header, sizeof(header), send_flags, e);
+    if (e)
+        return;
+
+    // one record per socket: the length of the name, the name, and the descriptor
+    for (const auto& [name, handle] : sockets) {
+        if (name.size() > max_name) {
+            e = std::make_error_code(std::errc::invalid_argument);
+            return;
+        }
+        char record[1 + max_name];
+        record[0] = static_cast<char>(name.size());
+        std::memcpy(record + 1, name.data(), name.size());
+        channel.send_fds(&handle, 1, record, 1 + name.size(), send_flags, e);
+        if (e)
+            return;
+    }
+
+    message_header ack {};
+    size_t received = channel.recv(&ack, sizeof(ack), 0, e);
+    if (e)
+        return;
+    if (!valid(ack, ack_magic, received) || ack.count != header.count)
+        e = std::make_error_code(std::errc::protocol_error);
+}
+
+std::vector<net::handoff_socket> net::recv_handoff(socket& channel)
+{
+    std::error_code e;
+    auto sockets = recv_handoff(channel, e);
+    THROW_IF_ERROR(e);
+    return sockets;
+}
+
+std::vector<net::handoff_socket> net::recv_handoff(socket& channel, std::error_code& e)
+{
+    message_header header {};
+    size_t received = channel.recv(&header, sizeof(header), 0, e);
+    if (e)
+        return {};
+    if (!valid(header, header_magic, received) || header.count > max_sockets) {
+        e = std::make_error_code(std::errc::protocol_error);
+        return {};
+    }
+
+    std::vector<handoff_socket> sockets;
+    sockets.reserve(header.count);
+    for (std::uint32_t i = 0; i < header.count; ++i) {
+        char record[1 + max_name];
+        socket sock;
+        size_t fds = 0;
+        received = channel.recv_fds(record, sizeof(record), &sock, 1, &fds, 0, e);
+        if (e)
+            return {};
+        if (received == 0 || fds != 1 || received != 1u + static_cast<unsigned char>(record[0])) {
+            e = std::make_error_code(std::errc::protocol_error);
+            return {};
+        }
+        sockets.push_back({ std::string(record + 1, received - 1), std::move(sock) });
+    }
+
+    message_header ack {};
+    std::memcpy(ack.magic, ack_magic, sizeof(ack_magic));
+    ack.count = header.count;
+    channel.send(&ack, sizeof(ack), send_flags, e);
+    if (e)
+        return {};
+    return sockets;
+}
+
+#endif
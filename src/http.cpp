@@ -0,0 +1,702 @@
+#include <cppnet/http.hpp>
+
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define CPPNET_HTTP_SSE2
+#include <emmintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define CPPNET_HTTP_AVX2
+#include <immintrin.h>
+#endif
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#define THROW_IF_ERROR(e) \
+    if (e)                \
+    throw std::system_error(e)
+
+namespace {
+
+class http_error_category_t : public std::error_category {
+public:
+    const char* name() const noexcept override
+    {
+        return "http";
+    }
+
+    std::string message(int ecode) const override
+    {
+        switch (static_cast<net::http::errc>(ecode)) {
+        case net::http::errc::bad_request_line:
+            return "malformed request line";
+        case net::http::errc::bad_status_line:
+            return "malformed status line";
+        case net::http::errc::bad_version:
+            return "unsupported HTTP version";
+        case net::http::errc::bad_header:
+            return "malformed header";
+        case net::http::errc::too_many_headers:
+            return "too many headers";
+        case net::http::errc::bad_content_length:
+            return "invalid Content-Length";
+        case net::http::errc::bad_transfer_encoding:
+            return "invalid Transfer-Encoding";
+        case net::http::errc::bad_chunk:
+            return "malformed chunked encoding";
+        }
+        return "unknown HTTP error";
+    }
+};
+
+const http_error_category_t http_error_category {};
+
+// control characters end the lines, and can't appear elsewhere but tabs
+
+const char* find_control_scalar(const char* p, const char* end) noexcept
+{
+    for (; p != end; ++p) {
+        auto c = static_cast<unsigned char>(*p);
+        if (c < 0x20 || c == 0x7f)
+            return p;
+    }
+    return end;
+}
+
+#ifdef CPPNET_HTTP_SSE2
+unsigned first_bit(unsigned mask) noexcept
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return index;
+#else
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+
+const char* find_control_sse2(const char* p, const char* end) noexcept
+{
+    const __m128i space = _mm_set1_epi8(0x20);
+    const __m128i del = _mm_set1_epi8(0x7f);
+    while (end - p >= 16) {
+        __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        // unsigned chars >= 0x20 are those that max(chars, 0x20) leaves alone
+        __m128i printable = _mm_cmpeq_epi8(_mm_max_epu8(chars, space), chars);
+        unsigned mask = (~static_cast<unsigned>(_mm_movemask_epi8(printable)) & 0xffff)
+            | static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(chars, del)));
+        if (mask)
+            return p + first_bit(mask);
+        p += 16;
+    }
+    return find_control_scalar(p, end);
+}
+#endif
+
+#ifdef CPPNET_HTTP_AVX2
+__attribute__((target("avx2"))) const char* find_control_avx2(const char* p, const char* end) noexcept
+{
+    const __m256i space = _mm256_set1_epi8(0x20);
+    const __m256i del = _mm256_set1_epi8(0x7f);
+    while (end - p >= 32) {
+        __m256i chars = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i printable = _mm256_cmpeq_epi8(_mm256_max_epu8(chars, space), chars);
+        unsigned mask = ~static_cast<unsigned>(_mm256_movemask_epi8(printable))
+            | static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chars, del)));
+        if (mask)
+            return p + first_bit(mask);
+        p += 32;
+    }
+    return find_control_sse2(p, end);
+}
+#endif
+
+using scanner = const char* (*)(const char*, const char*) noexcept;
+
+scanner select_scanner() noexcept
+{
+#ifdef CPPNET_HTTP_AVX2
+    if (__builtin_cpu_supports("avx2"))
+        return find_control_avx2;
+#endif
+#ifdef CPPNET_HTTP_SSE2
+    return find_control_sse2;
+#else
+    return find_control_scalar;
+#endif
+}
+
+const scanner find_control = select_scanner();
+
+// the CR or LF ending the line, another control character if the line has one, nullptr if it doesn't end in [p, end)
+const char* find_line_end(const char* p, const char* end) noexcept
+{
+    for (;;) {
+        p = find_control(p, end);
+        if (p == end)
+            return nullptr;
+        if (*p != '\t')
+            return p;
+        ++p;
+    }
+}
+
+// past the CRLF (or bare LF) at p, nullptr if incomplete, p if it's not a line end
+const char* skip_line_end(const char* p, const char* end) noexcept
+{
+    if (*p == '\n')
+        return p + 1;
+    if (*p != '\r')
+        return p;
+    if (p + 1 == end)
+        return nullptr;
+    return p[1] == '\n' ? p + 2 : p;
+}
+
+struct char_table {
+    bool token[256];
+    char lower[256];
+
+    constexpr char_table()
+        : token {}
+        , lower {}
+    {
+        for (int c = 0; c < 256; ++c) {
+            lower[c] = static_cast<char>(c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c);
+            token[c] = (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+        }
+        for (char c : "!#$%&'*+-.^_`|~")
+            token[static_cast<unsigned char>(c)] = c != '\0';
+    }
+};
+
+constexpr char_table chars;
+
+using net::http::iequals;
+
+std::string_view trim(std::string_view s) noexcept
+{
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t'))
+        s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t'))
+        s.remove_suffix(1);
+    return s;
+}
+
+// "HTTP/1.x", -1 if it's not
+int parse_version(std::string_view s) noexcept
+{
+    if (s.size() != 8 || s.compare(0, 7, "HTTP/1.") != 0 || s[7] < '0' || s[7] > '9')
+        return -1;
+    return s[7] - '0';
+}
+
+// the headers up to the empty line, returns past it or nullptr if incomplete
+const char* parse_headers(const char* p, const char* end, net::http::header_list& headers, std::error_code& e) noexcept
+{
+    headers.clear();
+    for (;;) {
+        if (p == end)
+            return nullptr;
+        if (*p == '\r' || *p == '\n') {
+            const char* next = skip_line_end(p, end);
+            if (next == p)
+                e = net::http::errc::bad_header;
+            return next;
+        }
+
+        // obsolete line folding is refused, as RFC 9112 allows
+        const char* name = p;
+        while (p != end && chars.token[static_cast<unsigned char>(*p)])
+            ++p;
+        if (p == end)
+            return nullptr;
+        if (*p != ':' || p == name) {
+            e = net::http::errc::bad_header;
+            return nullptr;
+        }
+
+        const char* value = p + 1;
+        const char* eol = find_line_end(value, end);
+        if (!eol)
+            return nullptr;
+        const char* next = skip_line_end(eol, end);
+        if (!next)
+            return nullptr;
+        if (next == eol) {
+            e = net::http::errc::bad_header;
+            return nullptr;
+        }
+
+        if (!headers.push_back({ { name, static_cast<std::size_t>(p - name) }, trim({ value, static_cast<std::size_t>(eol - value) }) })) {
+            e = net::http::errc::too_many_headers;
+            return nullptr;
+        }
+        p = next;
+    }
+}
+
+struct framing_headers {
+    bool has_length = false;
+    std::uint64_t length = 0;
+    bool has_transfer_encoding = false;
+    bool chunked = false; // the last transfer coding
+    bool close = false;
+    bool keep_alive = false;
+};
+
+bool scan_framing_headers(const net::http::header_list& headers, framing_headers& found, std::error_code& e) noexcept
+{
+    for (const net::http::header& h : headers) {
+        if (iequals(h.name, "content-length")) {
+            std::uint64_t length = 0;
+            auto [ptr, ec] = std::from_chars(h.value.data(), h.value.data() + h.value.size(), length);
+            if (h.value.empty() || ec != std::errc {} || ptr != h.value.data() + h.value.size() || (found.has_length && found.length != length)) {
+                e = net::http::errc::bad_content_length;
+                return false;
+            }
+            found.has_length = true;
+            found.length = length;
+        } else if (iequals(h.name, "transfer-encoding")) {
+            found.has_transfer_encoding = true;
+            std::string_view last = h.value;
+            std::size_t comma = last.rfind(',');
+            if (comma != std::string_view::npos)
+                last.remove_prefix(comma + 1);
+            found.chunked = iequals(trim(last), "chunked");
+        } else if (iequals(h.name, "connection")) {
+            std::string_view tokens = h.value;
+            while (!tokens.empty()) {
+                std::size_t comma = tokens.find(',');
+                std::string_view token = trim(tokens.substr(0, comma));
+                if (iequals(token, "close"))
+                    found.close = true;
+                else if (iequals(token, "keep-alive"))
+                    found.keep_alive = true;
+                tokens.remove_prefix(comma == std::string_view::npos ? tokens.size() : comma + 1);
+            }
+        }
+    }
+    return true;
+}
+
+bool keeps_alive(int minor_version, const framing_headers& found) noexcept
+{
+    if (found.close)
+        return false;
+    return minor_version >= 1 || found.keep_alive;
+}
+
+int hex_digit(char c) noexcept
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    c = chars.lower[static_cast<unsigned char>(c)];
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    return -1;
+}
+
+}
+
+const std::error_category& net::http::category() noexcept
+{
+    return http_error_category;
+}
+
+bool net::http::iequals(std::string_view a, std::string_view b) noexcept
+{
+    if (a.size() != b.size())
+        return false;
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        if (chars.lower[static_cast<unsigned char>(a[i])] != chars.lower[static_cast<unsigned char>(b[i])])
+            return false;
+    }
+    return true;
+}
+
+std::string_view net::http::header_list::find(std::string_view name) const noexcept
+{
+    for (const header& h : *this) {
+        if (iequals(h.name, name))
+            return h.value;
+    }
+    return {};
+}
+
+std::size_t net::http::parse(std::string_view buffer, request& req)
+{
+    std::error_code e;
+    std::size_t size = parse(buffer, req, e);
+    THROW_IF_ERROR(e);
+    return size;
+}
+
+std::size_t net::http::parse(std::string_view buffer, request& req, std::error_code& e) noexcept
+{
+    e.clear();
+    const char* begin = buffer.data();
+    const char* end = begin + buffer.size();
+
+    // RFC 9112 2.2, empty lines before the request line are ignored
+    const char* p = begin;
+    while (p != end && (*p == '\r' || *p == '\n'))
+        ++p;
+
+    const char* eol = find_line_end(p, end);
+    if (!eol)
+        return 0;
+    const char* next = skip_line_end(eol, end);
+    if (!next)
+        return 0;
+    if (next == eol) {
+        e = errc::bad_request_line;
+        return 0;
+    }
+
+    // method SP request-target SP HTTP-version
+    std::string_view line { p, static_cast<std::size_t>(eol - p) };
+    std::size_t method_end = line.find(' ');
+    if (method_end == 0 || method_end == std::string_view::npos) {
+        e = errc::bad_request_line;
+        return 0;
+    }
+    std::size_t target_end = line.find(' ', method_end + 1);
+    if (target_end == std::string_view::npos || target_end == method_end + 1) {
+        e = errc::bad_request_line;
+        return 0;
+    }
+    req.method = line.substr(0, method_end);
+    req.target = line.substr(method_end + 1, target_end - method_end - 1);
+    for (char c : req.method) {
+        if (!chars.token[static_cast<unsigned char>(c)]) {
+            e = errc::bad_request_line;
+            return 0;
+        }
+    }
+    if (req.target.find('\t') != std::string_view::npos) {
+        e = errc::bad_request_line;
+        return 0;
+    }
+    req.minor_version = parse_version(line.substr(target_end + 1));
+    if (req.minor_version < 0) {
+        e = errc::bad_version;
+        return 0;
+    }
+
+    const char* body = parse_headers(next, end, req.headers, e);
+    if (!body || e)
+        return 0;
+
+    framing_headers found;
+    if (!scan_framing_headers(req.headers, found, e))
+        return 0;
+    if (found.has_transfer_encoding && (found.has_length || !found.chunked)) {
+        e = errc::bad_transfer_encoding;
+        return 0;
+    }
+    req.framing = found.chunked ? body_framing::chunked : found.has_length && found.length ? body_framing::length : body_framing::none;
+    req.content_length = found.has_length ? found.length : 0;
+    req.keep_alive = keeps_alive(req.minor_version, found);
+    return static_cast<std::size_t>(body - begin);
+}
+
+std::size_t net::http::parse(std::string_view buffer, response& res)
+{
+    std::error_code e;
+    std::size_t size = parse(buffer, res, e);
+    THROW_IF_ERROR(e);
+    return size;
+}
+
+std::size_t net::http::parse(std::string_view buffer, response& res, std::error_code& e) noexcept
+{
+    e.clear();
+    const char* begin = buffer.data();
+    const char* end = begin + buffer.size();
+
+    const char* eol = find_line_end(begin, end);
+    if (!eol)
+        return 0;
+    const char* next = skip_line_end(eol, end);
+    if (!next)
+        return 0;
+    if (next == eol) {
+        e = errc::bad_status_line;
+        return 0;
+    }
+
+    // HTTP-version SP status-code SP [ reason-phrase ], some servers leave out the last space
+    std::string_view line { begin, static_cast<std::size_t>(eol - begin) };
+    if (line.size() < 12 || line[8] != ' ' || (line.size() > 12 && line[12] != ' ')) {
+        e = errc::bad_status_line;
+        return 0;
+    }
+    res.minor_version = parse_version(line.substr(0, 8));
+    if (res.minor_version < 0) {
+        e = errc::bad_version;
+        return 0;
+    }
+    res.status = 0;
+    for (char c : line.substr(9, 3)) {
+        if (c < '0' || c > '9') {
+            e = errc::bad_status_line;
+            return 0;
+        }
+        res.status = res.status * 10 + (c - '0');
+    }
+    res.reason = line.size() > 12 ? line.substr(13) : std::string_view {};
+
+    const char* body = parse_headers(next, end, res.headers, e);
+    if (!body || e)
+        return 0;
+
+    framing_headers found;
+    if (!scan_framing_headers(res.headers, found, e))
+        return 0;
+    if (res.status < 200 || res.status == 204 || res.status == 304)
+        res.framing = body_framing::none;
+    else if (found.has_transfer_encoding)
+        res.framing = found.chunked ? body_framing::chunked : body_framing::until_close;
+    else if (found.has_length)
+        res.framing = found.length ? body_framing::length : body_framing::none;
+    else
+        res.framing = body_framing::until_close;
+    res.content_length = found.has_length ? found.length : 0;
+    res.keep_alive = keeps_alive(res.minor_version, found) && res.framing != body_framing::until_close;
+    return static_cast<std::size_t>(body - begin);
+}
+
+std::size_t net::http::chunked_decoder::decode(std::string_view input, std::string_view& data, std::error_code& e) noexcept
+{
+    e.clear();
+    data = {};
+    const char* begin = input.data();
+    const char* end = begin + input.size();
+    const char* p = begin;
+
+    auto fail = [&] {
+        e = errc::bad_chunk;
+        return static_cast<std::size_t>(p - begin);
+    };
+
+    while (p != end && m_state != state::done) {
+        switch (m_state) {
+        case state::size: {
+            int digit = hex_digit(*p);
+            if (digit >= 0) {
+                if (++m_digits > 16)
+                    return fail();
+                m_remaining = m_remaining << 4 | static_cast<unsigned>(digit);
+                ++p;
+                break;
+            }
+            if (m_digits == 0)
+                return fail();
+            if (*p == ';' || *p == ' ' || *p == '\t')
+                m_state = state::extension;
+            else if (*p == '\r')
+                m_state = state::size_lf;
+            else if (*p == '\n')
+                m_state = m_remaining ? state::data : state::trailer_start;
+            else
+                return fail();
+            ++p;
+        } break;
+        case state::extension: {
+            auto lf = static_cast<const char*>(std::memchr(p, '\n', static_cast<std::size_t>(end - p)));
+            if (!lf) {
+                p = end;
+                break;
+            }
+            p = lf + 1;
+            m_state = m_remaining ? state::data : state::trailer_start;
+        } break;
+        case state::size_lf:
+            if (*p++ != '\n')
+                return fail();
+            m_state = m_remaining ? state::data : state::trailer_start;
+            break;
+        case state::data: {
+            std::size_t available = static_cast<std::size_t>(end - p);
+            std::size_t size = m_remaining < available ? static_cast<std::size_t>(m_remaining) : available;
+            data = { p, size };
+            p += size;
+            m_remaining -= size;
+            if (m_remaining == 0)
+                m_state = state::data_cr;
+            return static_cast<std::size_t>(p - begin);
+        }
+        case state::data_cr:
+            if (*p == '\r')
+                m_state = state::data_lf;
+            else if (*p == '\n')
+                m_state = state::size;
+            else
+                return fail();
+            ++p;
+            m_digits = 0;
+            break;
+        case state::data_lf:
+            if (*p++ != '\n')
+                return fail();
+            m_state = state::size;
+            break;
+        case state::trailer_start:
+            if (*p == '\r')
+                m_state = state::end_lf;
+            else if (*p == '\n')
+                m_state = state::done;
+            else
+                m_state = state::trailer;
+            ++p;
+            break;
+        case state::trailer: {
+            auto lf = static_cast<const char*>(std::memchr(p, '\n', static_cast<std::size_t>(end - p)));
+            if (!lf) {
+                p = end;
+                break;
+            }
+            p = lf + 1;
+            m_state = state::trailer_start;
+        } break;
+        case state::end_lf:
+            if (*p++ != '\n')
+                return fail();
+            m_state = state::done;
+            break;
+        case state::done:
+            break;
+        }
+    }
+    return static_cast<std::size_t>(p - begin);
+}
+
+net::http::response_builder& net::http::response_builder::status(int code, std::string_view reason)
+{
+    if (m_started)
+        throw std::logic_error("the status of a response comes before its headers");
+    if (code < 100 || code > 999)
+        throw std::invalid_argument("HTTP status codes have 3 digits");
+    m_status = code;
+    m_reason = reason;
+    return *this;
+}
+
+net::http::response_builder& net::http::response_builder::header(std::string_view name, std::string_view value)
+{
+    if (m_finished)
+        throw std::logic_error("the response is finished");
+    start_line();
+    m_out.append(name).append(": ").append(value).append("\r\n");
+    return *this;
+}
+
+void net::http::response_builder::finish(std::string_view body)
+{
+    if (m_finished)
+        throw std::logic_error("the response is finished");
+    start_line();
+    bool has_body = m_status >= 200 && m_status != 204 && m_status != 304;
+    if (has_body) {
+        char digits[20];
+        auto result = std::to_chars(std::begin(digits), std::end(digits), body.size());
+        m_out.append("Content-Length: ").append(digits, result.ptr).append("\r\n");
+    }
+    if (!m_keep_alive)
+        m_out.append("Connection: close\r\n");
+    m_out.append("\r\n");
+    if (has_body && !m_head_only)
+        m_out.append(body);
+    m_finished = true;
+}
+
+void net::http::response_builder::start_line()
+{
+    if (m_started)
+        return;
+    m_started = true;
+    char code[3] = { static_cast<char>('0' + m_status / 100), static_cast<char>('0' + m_status / 10 % 10), static_cast<char>('0' + m_status % 10) };
+    m_out.append("HTTP/1.1 ").append(code, 3).append(" ").append(m_reason.empty() ? reason_phrase(m_status) : m_reason).append("\r\n");
+}
+
+std::string_view net::http::reason_phrase(int status) noexcept
+{
+    switch (status) {
+    case 100:
+        return "Continue";
+    case 101:
+        return "Switching Protocols";
+    case 200:
+        return "OK";
+    case 201:
+        return "Created";
+    case 202:
+        return "Accepted";
+    case 204:
+        return "No Content";
+    case 206:
+        return "Partial Content";
+    case 301:
+        return "Moved Permanently";
+    case 302:
+        return "Found";
+    case 303:
+        return "See Other";
+    case 304:
+        return "Not Modified";
+    case 307:
+        return "Temporary Redirect";
+    case 308:
+        return "Permanent Redirect";
+    case 400:
+        return "Bad Request";
+    case 401:
+        return "Unauthorized";
+    case 403:
+        return "Forbidden";
+    case 404:
+        return "Not Found";
+    case 405:
+        return "Method Not Allowed";
+    case 408:
+        return "Request Timeout";
+    case 409:
+        return "Conflict";
+    case 411:
+        return "Length Required";
+    case 413:
+        return "Content Too Large";
+    case 414:
+        return "URI Too Long";
+    case 415:
+        return "Unsupported Media Type";
+    case 417:
+        return "Expectation Failed";
+    case 426:
+        return "Upgrade Required";
+    case 429:
+        return "Too Many Requests";
+    case 431:
+        return "Request Header Fields Too Large";
+    case 500:
+        return "Internal Server Error";
+    case 501:
+        return "Not Implemented";
+    case 502:
+        return "Bad Gateway";
+    case 503:
+        return "Service Unavailable";
+    case 504:
+        return "Gateway Timeout";
+    case 505:
+        return "HTTP Version Not Supported";
+    default:
+        return {};
+    }
+}
@@ -0,0 +1,434 @@
+#include <cppnet/http_client.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#include <ws2tcpip.h>
+#else
+#include <sys/time.h>
+#include <sys/uio.h>
+#endif
+
+#define THROW_IF_ERROR(e) \
+    if (e)                \
+    throw std::system_error(e)
+
+namespace {
+
+std::string_view rebase(std::string_view view, const char* from, const char* to) noexcept
+{
+    if (view.empty())
+        return {};
+    return { to + (view.data() - from), view.size() };
+}
+
+bool has_body_method(std::string_view method) noexcept
+{
+    return method == "POST" || method == "PUT" || method == "PATCH";
+}
+
+void append_head(std::string& out, std::string_view host, std::string_view service, const net::http::outgoing_request& req)
+{
+    out.append(req.method).append(" ").append(req.target).append(" HTTP/1.1\r\nHost: ");
+    bool literal_ipv6 = host.find(':') != std::string_view::npos;
+    if (literal_ipv6)
+        out.append("[");
+    out.append(host);
+    if (literal_ipv6)
+        out.append("]");
+    if (!service.empty() && service != "80" && service != "http")
+        out.append(":").append(service);
+    out.append("\r\n");
+    for (const net::http::header& h : req.headers)
+        out.append(h.name).append(": ").append(h.value).append("\r\n");
+    if (!req.body.empty() || has_body_method(req.method))
+        out.append("Content-Length: ").append(std::to_string(req.body.size())).append("\r\n");
+    out.append("\r\n");
+}
+
+}
+
+// the receive buffer of a connection, for the duration of a batch
+class net::http::client::reader {
+public:
+    reader(std::size_t read_size, std::size_t limit)
+        : m_buffer(read_size)
+        , m_read_size { read_size }
+        , m_limit { limit }
+    {
+    }
+
+    std::string_view view() const noexcept
+    {
+        return { m_buffer.data() + m_begin, m_end - m_begin };
+    }
+
+    void consume(std::size_t size) noexcept
+    {
+        m_consumed += size;
+        m_begin += size;
+        if (m_begin == m_end)
+            m_begin = m_end = 0;
+    }
+
+    // receives more, returns 0 at the end of the stream or on errors
+    std::size_t fill(socket& sock, std::error_code& e)
+    {
+        if (m_begin) {
+            std::memmove(m_buffer.data(), m_buffer.data() + m_begin, m_end - m_begin);
+            m_end -= m_begin;
+            m_begin = 0;
+        }
+        if (m_end == m_buffer.size()) {
+            if (m_buffer.size() >= m_limit) {
+                e = std::make_error_code(std::errc::message_size);
+                return 0;
+            }
+            m_buffer.resize(std::min(m_limit, m_buffer.size() + m_read_size));
+        }
+
+        std::size_t received;
+        do
+            received = sock.recv(m_buffer.data() + m_end, m_buffer.size() - m_end, 0, e);
+        while (e == std::errc::interrupted);
+        if (e) {
+            // what SO_RCVTIMEO reports
+            if (e == std::errc::operation_would_block || e == std::errc::resource_unavailable_try_again)
+                e = std::make_error_code(std::errc::timed_out);
+            return 0;
+        }
+        m_end += received;
+        return received;
+    }
+
+    // since the start of the batch, in bytes
+    std::size_t consumed() const noexcept
+    {
+        return m_consumed;
+    }
+
+    std::size_t received() const noexcept
+    {
+        return m_consumed + (m_end - m_begin);
+    }
+
+private:
+    std::vector<char> m_buffer;
+    std::size_t m_begin = 0;
+    std::size_t m_end = 0;
+    std::size_t m_consumed = 0;
+    std::size_t m_read_size;
+    std::size_t m_limit;
+};
+
+net::http::response_head::response_head(const response_head& rhs)
+{
+    assign(rhs.m_raw, rhs.m_response);
+}
+
+net::http::response_head& net::http::response_head::operator=(const response_head& rhs)
+{
+    if (this != &rhs)
+        assign(rhs.m_raw, rhs.m_response);
+    return *this;
+}
+
+void net::http::response_head::assign(std::string_view raw, const response& parsed)
+{
+    m_raw.assign(raw);
+    const char* from = raw.data();
+    const char* to = m_raw.data();
+
+    m_response = parsed;
+    m_response.reason = rebase(parsed.reason, from, to);
+    m_response.headers.clear();
+    for (const http::header& h : parsed.headers)
+        m_response.headers.push_back({ rebase(h.name, from, to), rebase(h.value, from, to) });
+}
+
+net::http::client::client(options opts)
+    : m_options { opts }
+    , m_pool { opts.pool }
+    , m_dns { opts.dns }
+{
+    if (m_options.max_pipeline == 0)
+        m_options.max_pipeline = 1;
+}
+
+bool net::http::client::idempotent(std::string_view method) noexcept
+{
+    return method == "GET" || method == "HEAD" || method == "PUT" || method == "DELETE" || method == "OPTIONS" || method == "TRACE";
+}
+
+net::http::response_head net::http::client::send(std::string_view host, std::string_view service, const outgoing_request& req, const body_sink& sink)
+{
+    std::error_code e;
+    response_head head = send(host, service, req, sink, e);
+    THROW_IF_ERROR(e);
+    return head;
+}
+
+net::http::response_head net::http::client::send(std::string_view host, std::string_view service, const outgoing_request& req, const body_sink& sink, std::error_code& e)
+{
+    batch_sink forward;
+    if (sink)
+        forward = [&sink](std::size_t, std::string_view data) { sink(data); };
+    std::vector<response_head> heads = batch(host, service, &req, 1, forward, e);
+    return heads.empty() ? response_head {} : std::move(heads.front());
+}
+
+net::http::response_head net::http::client::get(std::string_view host, std::string_view service, std::string_view target, std::string& body)
+{
+    std::error_code e;
+    response_head head = get(host, service, target, body, e);
+    THROW_IF_ERROR(e);
+    return head;
+}
+
+net::http::response_head net::http::client::get(std::string_view host, std::string_view service, std::string_view target, std::string& body, std::error_code& e)
+{
+    outgoing_request req;
+    req.target = target;
+    return send(host, service, req, [&body](std::string_view data) { body.append(data); }, e);
+}
+
+std::vector<net::http::response_head> net::http::client::send_batch(std::string_view host, std::string_view service, const std::vector<outgoing_request>& requests, const batch_sink& sink)
+{
+    std::error_code e;
+    std::vector<response_head> heads = send_batch(host, service, requests, sink, e);
+    THROW_IF_ERROR(e);
+    return heads;
+}
+
+std::vector<net::http::response_head> net::http::client::send_batch(std::string_view host, std::string_view service, const std::vector<outgoing_request>& requests, const batch_sink& sink, std::error_code& e)
+{
+    return batch(host, service, requests.data(), requests.size(), sink, e);
+}
+
+std::vector<net::http::response_head> net::http::client::batch(std::string_view host, std::string_view service, const outgoing_request* requests, std::size_t count, const batch_sink& sink, std::error_code& e)
+{
+    e.clear();
+    std::vector<response_head> heads;
+    heads.reserve(count);
+
+    dns_cache::result addresses = m_dns.resolve(host, service, AF_UNSPEC, m_options.pool.type, m_options.pool.protocol, 0, e);
+    if (e)
+        return heads;
+
+    constexpr std::size_t none = static_cast<std::size_t>(-1);
+    std::size_t retried = none; // the request that was already sent again once
+
+    while (heads.size() < count) {
+        connection_pool::connection conn = connect(addresses, e);
+        if (e)
+            return heads;
+
+        // idempotent requests are pipelined, the others go alone
+        std::size_t first = heads.size();
+        std::size_t last = first + 1;
+        if (idempotent(requests[first].method)) {
+            while (last < count && last - first < m_options.max_pipeline && idempotent(requests[last].method))
+                ++last;
+        }
+
+        write(conn, host, service, requests + first, last - first, e);
+        reader in { m_options.read_size, m_options.max_head_size + m_options.read_size };
+        bool keep_alive = true;
+        std::size_t answered = 0; // where the response being read starts in the stream
+        for (std::size_t i = first; i < last && keep_alive && !e; ++i) {
+            response_head head;
+            keep_alive = read(conn, in, requests[i], head, i, sink, e);
+            if (!e) {
+                heads.push_back(std::move(head));
+                answered = in.consumed();
+            }
+        }
+
+        if (e) {
+            conn.discard();
+            // a kept alive connection may have been closed by the server meanwhile,
+            // what it didn't start answering is sent again once, if it's safe to: once a byte of
+            // the response arrived, a part of its body may have gone to the sink already
+            std::size_t failed = heads.size();
+            if (failed == retried || !idempotent(requests[failed].method) || in.received() > answered)
+                return heads;
+            retried = failed;
+            e.clear();
+            continue;
+        }
+
+        // those the server won't answer, after a "Connection: close", are sent on another connection
+        if (!keep_alive || heads.size() < last || !in.view().empty())
+            conn.discard();
+    }
+    return heads;
+}
+
+net::connection_pool::connection net::http::client::connect(const dns_cache::result& addresses, std::error_code& e) noexcept
+{
+    e = std::make_error_code(std::errc::host_unreachable);
+    for (const address_info& ainfo : *addresses) {
+        connection_pool::connection conn = m_pool.acquire(ainfo.address(), e);
+        if (e)
+            continue;
+        if (!conn.reused() && m_options.timeout.count() > 0) {
+#ifdef _WIN32
+            DWORD timeout = static_cast<DWORD>(m_options.timeout.count());
+#else
+            timeval timeout {};
+            timeout.tv_sec = static_cast<time_t>(m_options.timeout.count() / 1000);
+            timeout.tv_usec = static_cast<suseconds_t>(m_options.timeout.count() % 1000 * 1000);
+#endif
+            std::error_code ignored;
+            conn->setsockopt(SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout), ignored);
+            conn->setsockopt(SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout), ignored);
+        }
+        return conn;
+    }
+    return {};
+}
+
+void net::http::client::write(connection_pool::connection& conn, std::string_view host, std::string_view service, const outgoing_request* requests, std::size_t count, std::error_code& e)
+{
+    std::string heads;
+    std::vector<std::size_t> ends(count); // of each head in heads
+    for (std::size_t i = 0; i < count; ++i) {
+        append_head(heads, host, service, requests[i]);
+        ends[i] = heads.size();
+    }
+
+#ifdef MSG_NOSIGNAL
+    constexpr int flags = MSG_NOSIGNAL;
+#else
+    constexpr int flags = 0;
+#endif
+
+#ifndef _WIN32
+    // the heads and the bodies, in one system call
+    std::vector<iovec> pieces;
+    pieces.reserve(2 * count);
+    for (std::size_t i = 0; i < count; ++i) {
+        std::size_t begin = i ? ends[i - 1] : 0;
+        pieces.push_back({ heads.data() + begin, ends[i] - begin });
+        if (!requests[i].body.empty())
+            pieces.push_back({ const_cast<char*>(requests[i].body.data()), requests[i].body.size() });
+    }
+
+    std::size_t next = 0;
+    while (next < pieces.size()) {
+        msghdr message {};
+        message.msg_iov = pieces.data() + next;
+        message.msg_iovlen = std::min<std::size_t>(pieces.size() - next, 1024); // IOV_MAX
+        std::size_t sent = conn->sendmsg(&message, flags, e);
+        if (e == std::errc::interrupted)
+            continue;
+        if (e)
+            break;
+        while (sent) {
+            if (sent >= pieces[next].iov_len) {
+                sent -= pieces[next].iov_len;
+                ++next;
+            } else {
+                pieces[next].iov_base = static_cast<char*>(pieces[next].iov_base) + sent;
+                pieces[next].iov_len -= sent;
+                sent = 0;
+            }
+        }
+    }
+#else
+    std::string all;
+    for (std::size_t i = 0; i < count; ++i) {
+        all.append(heads, i ? ends[i - 1] : 0, ends[i] - (i ? ends[i - 1] : 0));
+        all.append(requests[i].body);
+    }
+    std::string_view rest = all;
+    while (!rest.empty()) {
+        std::size_t sent = conn->send(rest, flags, e);
+        if (e)
+            break;
+        rest.remove_prefix(sent);
+    }
+#endif
+    // what SO_SNDTIMEO reports
+    if (e == std::errc::operation_would_block || e == std::errc::resource_unavailable_try_again)
+        e = std::make_error_code(std::errc::timed_out);
+}
+
+bool net::http::client::read(connection_pool::connection& conn, reader& in, const outgoing_request& req, response_head& head, std::size_t index, const batch_sink& sink, std::error_code& e)
+{
+    auto more = [&] {
+        if (in.fill(conn.socket(), e))
+            return true;
+        if (!e)
+            e = std::make_error_code(std::errc::connection_reset); // closed in the middle of a response
+        return false;
+    };
+
+    response res;
+    std::size_t size;
+    for (;;) {
+        size = parse(in.view(), res, e);
+        if (e)
+            return false;
+        if (size == 0) {
+            if (!more())
+                return false;
+            continue;
+        }
+        // interim responses, as 100 Continue
+        if (res.status >= 100 && res.status < 200 && res.status != 101) {
+            in.consume(size);
+            continue;
+        }
+        break;
+    }
+    head.assign(in.view().substr(0, size), res);
+    in.consume(size);
+
+    auto deliver = [&](std::string_view data) {
+        if (sink && !data.empty())
+            sink(index, data);
+    };
+
+    body_framing framing = req.method == "HEAD" || res.status == 101 ? body_framing::none : res.framing;
+    switch (framing) {
+    case body_framing::none:
+        break;
+    case body_framing::length: {
+        std::uint64_t remaining = res.content_length;
+        while (remaining) {
+            if (in.view().empty() && !more())
+                return false;
+            std::string_view data = in.view().substr(0, static_cast<std::size_t>(std::min<std::uint64_t>(remaining, in.view().size())));
+            deliver(data);
+            in.consume(data.size());
+            remaining -= data.size();
+        }
+    } break;
+    case body_framing::chunked: {
+        chunked_decoder decoder;
+        while (!decoder.done()) {
+            std::string_view data;
+            std::size_t used = decoder.decode(in.view(), data, e);
+            if (e)
+                return false;
+            if (used == 0) {
+                if (!more())
+                    return false;
+                continue;
+            }
+            deliver(data);
+            in.consume(used);
+        }
+    } break;
+    case body_framing::until_close:
+        for (;;) {
+            deliver(in.view());
+            in.consume(in.view().size());
+            if (!in.fill(conn.socket(), e))
+                return false;
+        }
+    }
+    return res.keep_alive && res.status != 101;
+}
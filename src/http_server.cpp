@@ -0,0 +1,336 @@
+#ifdef __linux__
+#include <cppnet/http_server.hpp>
+
+#include <cstring>
+#include <iterator>
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#define THROW_IF_ERROR(e) \
+    if (e)                \
+    throw std::system_error(e)
+
+namespace {
+
+std::string_view rebase(std::string_view view, const char* from, const char* to) noexcept
+{
+    if (view.empty())
+        return {};
+    return { to + (view.data() - from), view.size() };
+}
+
+// when the bytes req was parsed from moved, from from to to
+void rebase(net::http::request& req, const char* from, const char* to) noexcept
+{
+    req.method = rebase(req.method, from, to);
+    req.target = rebase(req.target, from, to);
+    net::http::header_list headers = req.headers;
+    req.headers.clear();
+    for (std::size_t i = 0; i < headers.size(); ++i)
+        req.headers.push_back({ rebase(headers[i].name, from, to), rebase(headers[i].value, from, to) });
+}
+
+}
+
+net::http::server::server(socket listener, handler h)
+    : server(std::move(listener), std::move(h), options {})
+{
+}
+
+net::http::server::server(socket listener, handler h, options opts)
+    : m_listener { std::move(listener) }
+    , m_handler { std::move(h) }
+    , m_options { opts }
+{
+    m_listener.setblocking(false);
+    m_wakeup = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_wakeup < 0)
+        throw std::system_error(errno, std::system_category());
+
+    std::error_code e;
+    if (!m_poller.add(m_listener.native_handle(), epoll::read, e) || !m_poller.add(m_wakeup, epoll::read, e)) {
+        ::close(m_wakeup);
+        throw std::system_error(e);
+    }
+}
+
+net::http::server::~server() noexcept
+{
+    ::close(m_wakeup);
+}
+
+std::size_t net::http::server::run_once(std::optional<std::chrono::milliseconds> timeout)
+{
+    std::error_code e;
+    std::size_t handled = run_once(timeout, e);
+    THROW_IF_ERROR(e);
+    return handled;
+}
+
+std::size_t net::http::server::run_once(std::optional<std::chrono::milliseconds> timeout, std::error_code& e)
+{
+    m_poller.execute(timeout, e);
+    if (e) {
+        if (e == std::errc::interrupted)
+            e.clear();
+        return 0;
+    }
+    m_events.clear();
+    m_poller.get(std::back_inserter(m_events));
+
+    for (auto [fd, events] : m_events) {
+        if (fd == m_listener.native_handle()) {
+            accept_all();
+            continue;
+        }
+        if (fd == m_wakeup) {
+            std::uint64_t count;
+            [[maybe_unused]] auto ignored = ::read(m_wakeup, &count, sizeof(count));
+            continue;
+        }
+
+        auto found = m_connections.find(fd);
+        if (found == m_connections.end())
+            continue;
+        connection& c = found->second;
+        if (events & epoll::write) {
+            if (!flush(fd, c)) {
+                drop(fd);
+                continue;
+            }
+        }
+        if (events & (epoll::read | epoll::hang_up | epoll::exception))
+            on_readable(fd, c);
+    }
+    return m_events.size();
+}
+
+void net::http::server::run()
+{
+    std::error_code e;
+    run(e);
+    THROW_IF_ERROR(e);
+}
+
+void net::http::server::run(std::error_code& e)
+{
+    e.clear();
+    while (!m_stopping.load(std::memory_order_acquire) && !e)
+        run_once(std::nullopt, e);
+    m_stopping.store(false, std::memory_order_release);
+}
+
+void net::http::server::stop() noexcept
+{
+    m_stopping.store(true, std::memory_order_release);
+    std::uint64_t one = 1;
+    [[maybe_unused]] auto ignored = ::write(m_wakeup, &one, sizeof(one));
+}
+
+void net::http::server::accept_all()
+{
+    for (;;) {
+        std::error_code e;
+        socket accepted = m_listener.accept(e);
+        if (e)
+            return; // EAGAIN, or ECONNABORTED and the like that only concern that connection
+
+        accepted.setblocking(false, e);
+        int enable = 1;
+        accepted.setsockopt(IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable), e); // fails harmlessly on unix sockets
+        int fd = accepted.native_handle();
+        if (!m_poller.add(fd, epoll::read))
+            continue;
+        connection& c = m_connections[fd];
+        c.sock = std::move(accepted);
+    }
+}
+
+void net::http::server::on_readable(int fd, connection& c)
+{
+    if (c.in_end == c.in.size()) {
+        const char* from = c.in.data() + c.in_begin;
+        if (c.in_begin) {
+            std::memmove(c.in.data(), c.in.data() + c.in_begin, c.in_end - c.in_begin);
+            c.in_end -= c.in_begin;
+            c.in_begin = 0;
+        } else {
+            c.in.resize(c.in.size() + m_options.read_size);
+        }
+        if (c.head_size)
+            rebase(c.req, from, c.in.data());
+    }
+
+    std::error_code e;
+    std::size_t received = c.sock.recv(c.in.data() + c.in_end, c.in.size() - c.in_end, 0, e);
+    if (e) {
+        if (e == std::errc::operation_would_block || e == std::errc::resource_unavailable_try_again || e == std::errc::interrupted)
+            return;
+        drop(fd);
+        return;
+    }
+    if (received == 0) {
+        // the peer is done sending, it still gets the responses to what it sent
+        c.closing = true;
+        m_poller.defer_modify(fd, epoll::write);
+        c.writing = true;
+    }
+    c.in_end += received;
+
+    process(c);
+    if (!flush(fd, c))
+        drop(fd);
+}
+
+void net::http::server::process(connection& c)
+{
+    std::string_view buffered { c.in.data() + c.in_begin, c.in_end - c.in_begin };
+    std::size_t used = 0;
+    request req;
+
+    // every complete request that is buffered is answered, in order
+    while (!c.closing && used < buffered.size()) {
+        std::string_view rest = buffered.substr(used);
+        std::error_code e;
+        std::size_t head;
+        if (used == 0 && c.head_size) {
+            // waiting for its body, the head was parsed already
+            head = c.head_size;
+            req = c.req;
+        } else {
+            head = parse(rest, req, e);
+        }
+        if (e) {
+            fail(c, 400);
+            break;
+        }
+        if (head == 0) {
+            if (rest.size() > m_options.max_head_size)
+                fail(c, 431);
+            break;
+        }
+
+        std::string_view body;
+        std::size_t size = head;
+        bool complete = true;
+        if (req.framing == body_framing::length) {
+            if (req.content_length > m_options.max_body_size) {
+                fail(c, 413);
+                break;
+            }
+            if (rest.size() - head < req.content_length)
+                complete = false;
+            else {
+                body = rest.substr(head, static_cast<std::size_t>(req.content_length));
+                size += body.size();
+            }
+        } else if (req.framing == body_framing::chunked) {
+            // only what arrived since the last read is decoded, the state of the incomplete request
+            // is in the connection
+            std::string_view input = rest.substr(head + c.chunked_size);
+            while (!c.decoder.done()) {
+                std::string_view data;
+                std::size_t consumed = c.decoder.decode(input, data, e);
+                if (e || consumed == 0)
+                    break;
+                c.body.append(data);
+                input.remove_prefix(consumed);
+                c.chunked_size += consumed;
+            }
+            size += c.chunked_size;
+            if (e) {
+                fail(c, 400);
+                break;
+            }
+            if (c.body.size() > m_options.max_body_size || rest.size() - head > m_options.max_body_size + m_options.max_head_size) {
+                fail(c, 413);
+                break;
+            }
+            complete = c.decoder.done();
+            body = c.body;
+        }
+
+        if (!complete) {
+            if (!c.continue_sent && iequals(req.headers.find("Expect"), "100-continue")) {
+                c.out.append("HTTP/1.1 100 Continue\r\n\r\n");
+                c.continue_sent = true;
+            }
+            c.req = req;
+            c.head_size = head;
+            break;
+        }
+        c.continue_sent = false;
+
+        std::size_t response_start = c.out.size();
+        response_builder res { c.out };
+        res.keep_alive(req.keep_alive).head_only(req.method == "HEAD");
+        try {
+            m_handler(req, body, res);
+            if (!res.finished())
+                res.finish();
+        } catch (...) {
+            c.out.resize(response_start);
+            fail(c, 500);
+            break;
+        }
+        if (!res.keeps_alive())
+            c.closing = true;
+        used += size;
+        c.body.clear();
+        c.decoder.reset();
+        c.chunked_size = 0;
+        c.head_size = 0;
+    }
+
+    c.in_begin += used;
+    if (c.in_begin == c.in_end)
+        c.in_begin = c.in_end = 0;
+}
+
+bool net::http::server::flush(int fd, connection& c)
+{
+    while (c.out_sent < c.out.size()) {
+        std::error_code e;
+        std::size_t sent = c.sock.send(c.out.data() + c.out_sent, c.out.size() - c.out_sent, MSG_NOSIGNAL, e);
+        if (e) {
+            if (e == std::errc::interrupted)
+                continue;
+            if (e != std::errc::operation_would_block && e != std::errc::resource_unavailable_try_again)
+                return false;
+            // stop reading until the peer takes what it asked for
+            if (!c.writing) {
+                m_poller.defer_modify(fd, epoll::write);
+                c.writing = true;
+            }
+            return true;
+        }
+        c.out_sent += sent;
+    }
+
+    c.out.clear();
+    c.out_sent = 0;
+    if (c.closing)
+        return false;
+    if (c.writing) {
+        m_poller.defer_modify(fd, epoll::read);
+        c.writing = false;
+    }
+    return true;
+}
+
+void net::http::server::fail(connection& c, int status)
+{
+    response_builder { c.out }.status(status).keep_alive(false).finish();
+    c.closing = true;
+}
+
+void net::http::server::drop(int fd)
+{
+    m_poller.remove(fd);
+    m_connections.erase(fd);
+}
+
+#endif
@@ -0,0 +1,175 @@
+#include <cppnet/prefix_table.hpp>
+
+#include <ostream>
+
+#ifdef _WIN32
+#include <ws2tcpip.h>
+#endif
+
+namespace {
+
+std::uint64_t load_big_endian(const std::uint8_t* bytes, std::size_t size) noexcept
+{
+    std::uint64_t value = 0;
+    for (std::size_t i = 0; i < size; ++i)
+        value = value << 8 | bytes[i];
+    return value << (8 * (8 - size));
+}
+
+unsigned max_length(int family) noexcept
+{
+    return family == AF_INET ? 32 : 128;
+}
+
+}
+
+net::ip_prefix::ip_prefix(const address& addr, unsigned length)
+{
+    switch (addr.family()) {
+    case AF_INET:
+        std::memcpy(m_bytes.data(), &reinterpret_cast<const sockaddr_in*>(addr.address_pointer())->sin_addr, 4);
+        break;
+    case AF_INET6:
+        std::memcpy(m_bytes.data(), &reinterpret_cast<const sockaddr_in6*>(addr.address_pointer())->sin6_addr, 16);
+        break;
+    default:
+        throw std::invalid_argument("the address is not an IP address");
+    }
+    if (length > max_length(addr.family()))
+        throw std::invalid_argument("the prefix length is too long for the address family");
+
+    m_family = addr.family();
+    m_length = static_cast<std::uint8_t>(length);
+
+    // clear the host bits
+    for (unsigned i = length / 8; i < 16; ++i) {
+        unsigned kept = i == length / 8 ? length % 8 : 0;
+        m_bytes[i] &= static_cast<std::uint8_t>(0xff00u >> kept);
+    }
+}
+
+bool net::ip_prefix::contains(const address& addr) const noexcept
+{
+    if (addr.family() != m_family)
+        return false;
+    return detail::prefix_matches(detail::make_prefix_key(addr.address_pointer()), detail::make_prefix_key(*this), m_length);
+}
+
+net::address net::ip_prefix::network() const noexcept
+{
+    if (m_family == AF_INET) {
+        sockaddr_in in {};
+        in.sin_family = AF_INET;
+        std::memcpy(&in.sin_addr, m_bytes.data(), 4);
+        return { reinterpret_cast<const sockaddr*>(&in), sizeof(in) };
+    }
+    if (m_family == AF_INET6) {
+        sockaddr_in6 in6 {};
+        in6.sin6_family = AF_INET6;
+        std::memcpy(&in6.sin6_addr, m_bytes.data(), 16);
+        return { reinterpret_cast<const sockaddr*>(&in6), sizeof(in6) };
+    }
+    return {};
+}
+
+bool net::operator==(const ip_prefix& a, const ip_prefix& b) noexcept
+{
+    return a.family() == b.family() && a.length() == b.length() && a.bytes() == b.bytes();
+}
+
+bool net::operator<(const ip_prefix& a, const ip_prefix& b) noexcept
+{
+    if (a.family() != b.family())
+        return a.family() < b.family();
+    if (a.bytes() != b.bytes())
+        return a.bytes() < b.bytes();
+    return a.length() < b.length();
+}
+
+std::from_chars_result net::from_chars(const char* first, const char* last, ip_prefix& prefix) noexcept
+{
+    address addr;
+    auto [p, ec] = from_chars(first, last, addr);
+    if (ec != std::errc {})
+        return { p, ec };
+
+    // a network, not an endpoint
+    auto in6 = reinterpret_cast<const sockaddr_in6*>(addr.address_pointer());
+    if ((addr.family() == AF_INET6 && in6->sin6_scope_id) || reinterpret_cast<const sockaddr_in*>(addr.address_pointer())->sin_port)
+        return { first, std::errc::invalid_argument };
+
+    unsigned length = max_length(addr.family());
+    if (p != last && *p == '/' && p + 1 != last && static_cast<unsigned char>(p[1] - '0') < 10) {
+        ++p;
+        length = 0;
+        while (p != last && static_cast<unsigned char>(*p - '0') < 10) {
+            length = length * 10 + static_cast<unsigned>(*p++ - '0');
+            if (length > 128) {
+                while (p != last && static_cast<unsigned char>(*p - '0') < 10)
+                    ++p;
+                break;
+            }
+        }
+        if (length > max_length(addr.family()))
+            return { p, std::errc::result_out_of_range };
+    }
+
+    prefix = ip_prefix { addr, length };
+    return { p, std::errc {} };
+}
+
+std::to_chars_result net::to_chars(char* first, char* last, const ip_prefix& prefix) noexcept
+{
+    if (prefix.family() != AF_INET && prefix.family() != AF_INET6)
+        return { first, std::errc::address_family_not_supported };
+
+    char buffer[max_ip_address_chars + 4];
+    auto [end, ec] = to_chars(buffer, buffer + max_ip_address_chars, prefix.network());
+    if (ec != std::errc {})
+        return { first, ec };
+
+    // without the brackets around IPv6 addresses, there's no port to tell apart
+    char* begin = buffer;
+    if (prefix.family() == AF_INET6) {
+        ++begin;
+        --end;
+    }
+    *end++ = '/';
+    unsigned length = prefix.length();
+    if (length >= 100)
+        *end++ = static_cast<char>('0' + length / 100);
+    if (length >= 10)
+        *end++ = static_cast<char>('0' + length / 10 % 10);
+    *end++ = static_cast<char>('0' + length % 10);
+
+    std::size_t size = static_cast<std::size_t>(end - begin);
+    if (static_cast<std::size_t>(last - first) < size)
+        return { last, std::errc::value_too_large };
+    std::memcpy(first, begin, size);
+    return { first + size, std::errc {} };
+}
+
+std::ostream& net::operator<<(std::ostream& os, const ip_prefix& prefix)
+{
+    char buffer[max_ip_address_chars];
+    auto result = to_chars(std::begin(buffer), std::end(buffer), prefix);
+    return os.write(buffer, result.ptr - buffer);
+}
+
+net::detail::prefix_key net::detail::make_prefix_key(const sockaddr_storage* addr) noexcept
+{
+    if (addr->ss_family == AF_INET) {
+        auto bytes = reinterpret_cast<const std::uint8_t*>(&reinterpret_cast<const sockaddr_in*>(addr)->sin_addr);
+        return { load_big_endian(bytes, 4), 0 };
+    }
+    auto bytes = reinterpret_cast<const std::uint8_t*>(&reinterpret_cast<const sockaddr_in6*>(addr)->sin6_addr);
+    return { load_big_endian(bytes, 8), load_big_endian(bytes + 8, 8) };
+}
+
+net::detail::prefix_key net::detail::make_prefix_key(const ip_prefix& prefix) noexcept
+{
+    const std::uint8_t* bytes = prefix.bytes().data();
+    if (prefix.family() == AF_INET)
+        return { load_big_endian(bytes, 4), 0 };
+    return { load_big_endian(bytes, 8), load_big_endian(bytes + 8, 8) };
+}
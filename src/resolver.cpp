@@ -0,0 +1,820 @@
+#ifdef __linux__
+#include <cppnet/resolver.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <unistd.h>
+
+#define THROW_IF_ERROR(e) \
+    if (e)                \
+    throw std::system_error(e)
+
+namespace {
+
+constexpr std::uint16_t dns_port = 53;
+constexpr std::uint16_t type_a = 1;
+constexpr std::uint16_t type_cname = 5;
+constexpr std::uint16_t type_aaaa = 28;
+constexpr std::uint16_t type_opt = 41;
+constexpr std::uint16_t class_in = 1;
+constexpr std::size_t header_size = 12;
+constexpr std::size_t max_udp_answer = 1232; // avoids fragmentation, as recommended by the DNS flag day 2020
+constexpr unsigned max_cnames = 16;
+
+std::error_code gai_error(int code) noexcept
+{
+    return { code, net::addrinfo_category() };
+}
+
+std::string lowercase(std::string_view name)
+{
+    std::string result(name);
+    for (char& c : result)
+        if (c >= 'A' && c <= 'Z')
+            c = static_cast<char>(c - 'A' + 'a');
+    return result;
+}
+
+std::string_view without_root(std::string_view name) noexcept
+{
+    if (!name.empty() && name.back() == '.')
+        name.remove_suffix(1);
+    return name;
+}
+
+bool equal_names(std::string_view a, std::string_view b) noexcept
+{
+    a = without_root(a);
+    b = without_root(b);
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+        auto lower = [](char c) { return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c; };
+        return lower(x) == lower(y);
+    });
+}
+
+std::uint16_t read16(const unsigned char* p) noexcept
+{
+    return static_cast<std::uint16_t>(p[0] << 8 | p[1]);
+}
+
+void write16(std::vector<unsigned char>& out, std::uint16_t value)
+{
+    out.push_back(static_cast<unsigned char>(value >> 8));
+    out.push_back(static_cast<unsigned char>(value));
+}
+
+// false if the name can't be encoded: empty labels, labels over 63 bytes or names over 255
+bool encode_query(std::vector<unsigned char>& out, std::uint16_t id, std::string_view name, std::uint16_t qtype, bool edns0)
+{
+    out.clear();
+    write16(out, id);
+    write16(out, 0x0100); // standard query, recursion desired
+    write16(out, 1); // questions
+    write16(out, 0); // answers
+    write16(out, 0); // authority
+    write16(out, edns0 ? 1 : 0); // additional
+
+    name = without_root(name);
+    std::size_t encoded = 1;
+    while (!name.empty()) {
+        std::size_t dot = name.find('.');
+        std::string_view label = name.substr(0, dot);
+        if (label.empty() || label.size() > 63)
+            return false;
+        encoded += 1 + label.size();
+        out.push_back(static_cast<unsigned char>(label.size()));
+        out.insert(out.end(), label.begin(), label.end());
+        name.remove_prefix(dot == std::string_view::npos ? name.size() : dot + 1);
+    }
+    if (encoded > 255)
+        return false;
+    out.push_back(0);
+    write16(out, qtype);
+    write16(out, class_in);
+
+    if (edns0) {
+        out.push_back(0); // root
+        write16(out, type_opt);
+        write16(out, max_udp_answer);
+        write16(out, 0); // extended rcode and version
+        write16(out, 0); // flags
+        write16(out, 0); // no options
+    }
+    return true;
+}
+
+// Reads a possibly compressed name at offset, which is left past it
+bool read_name(const unsigned char* message, std::size_t size, std::size_t& offset, std::string& name)
+{
+    name.clear();
+    std::size_t position = offset;
+    bool jumped = false;
+    for (unsigned hops = 0; hops < 64;) {
+        if (position >= size)
+            return false;
+        unsigned char length = message[position];
+        if ((length & 0xc0) == 0xc0) { // compression pointer
+            if (position + 1 >= size)
+                return false;
+            if (!jumped)
+                offset = position + 2;
+            jumped = true;
+            position = static_cast<std::size_t>(length & 0x3f) << 8 | message[position + 1];
+            ++hops;
+        } else if (length & 0xc0) {
+            return false;
+        } else if (length == 0) {
+            if (!jumped)
+                offset = position + 1;
+            return name.size() <= 255;
+        } else {
+            if (position + 1 + length > size)
+                return false;
+            if (!name.empty())
+                name.push_back('.');
+            name.append(reinterpret_cast<const char*>(message + position + 1), length);
+            position += 1 + length;
+        }
+    }
+    return false;
+}
+
+struct record {
+    std::string name;
+    std::uint16_t type;
+    std::size_t data; // offset of the rdata
+    std::uint16_t data_size;
+};
+
+bool parse_address(std::string_view text, std::uint16_t port, net::address& addr) noexcept
+{
+    char buffer[INET6_ADDRSTRLEN + IF_NAMESIZE + 1];
+    if (text.empty() || text.size() >= sizeof(buffer))
+        return false;
+    std::memcpy(buffer, text.data(), text.size());
+    buffer[text.size()] = '\0';
+
+    sockaddr_in in {};
+    if (inet_pton(AF_INET, buffer, &in.sin_addr) == 1) {
+        in.sin_family = AF_INET;
+        in.sin_port = htons(port);
+        addr = net::address { reinterpret_cast<const sockaddr*>(&in), sizeof(in) };
+        return true;
+    }
+
+    sockaddr_in6 in6 {};
+    if (char* scope = std::strchr(buffer, '%')) {
+        *scope++ = '\0';
+        in6.sin6_scope_id = if_nametoindex(scope);
+        if (in6.sin6_scope_id == 0) {
+            char* end = nullptr;
+            unsigned long index = std::strtoul(scope, &end, 10);
+            if (*scope == '\0' || *end != '\0' || index > UINT32_MAX)
+                return false;
+            in6.sin6_scope_id = static_cast<std::uint32_t>(index);
+        }
+    }
+    if (inet_pton(AF_INET6, buffer, &in6.sin6_addr) == 1) {
+        in6.sin6_family = AF_INET6;
+        in6.sin6_port = htons(port);
+        addr = net::address { reinterpret_cast<const sockaddr*>(&in6), sizeof(in6) };
+        return true;
+    }
+    return false;
+}
+
+net::address with_port(const net::address& addr, std::uint16_t port)
+{
+    sockaddr_storage storage = *addr.address_pointer();
+    if (storage.ss_family == AF_INET)
+        reinterpret_cast<sockaddr_in*>(&storage)->sin_port = htons(port);
+    else
+        reinterpret_cast<sockaddr_in6*>(&storage)->sin6_port = htons(port);
+    return { reinterpret_cast<const sockaddr*>(&storage), addr.address_size() };
+}
+
+bool in_progress(const std::error_code& e) noexcept
+{
+    return e == std::errc::operation_in_progress || e == std::errc::operation_would_block || e == std::errc::resource_unavailable_try_again;
+}
+
+}
+
+net::resolver_config net::resolver_config::from_resolv_conf(const char* path)
+{
+    resolver_config config;
+    bool has_search = false;
+
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        std::size_t comment = line.find_first_of("#;");
+        if (comment != std::string::npos)
+            line.resize(comment);
+        std::istringstream words(line);
+        std::string keyword;
+        if (!(words >> keyword))
+            continue;
+
+        if (keyword == "nameserver") {
+            std::string server;
+            address addr;
+            if (words >> server && parse_address(server, dns_port, addr))
+                config.nameservers.push_back(addr);
+        } else if (keyword == "domain" || keyword == "search") {
+            // the last of them wins
+            config.search.clear();
+            has_search = true;
+            for (std::string domain; words >> domain;)
+                if (domain != ".")
+                    config.search.push_back(std::string(without_root(domain)));
+        } else if (keyword == "options") {
+            for (std::string option; words >> option;) {
+                auto value = [&](std::string_view name, unsigned max) -> std::optional<unsigned> {
+                    if (option.compare(0, name.size(), name) != 0)
+                        return std::nullopt;
+                    unsigned long n = std::strtoul(option.c_str() + name.size(), nullptr, 10);
+                    return static_cast<unsigned>(std::min<unsigned long>(n, max));
+                };
+                if (auto n = value("ndots:", 15))
+                    config.ndots = *n;
+                else if (auto n = value("timeout:", 30))
+                    config.timeout = std::chrono::seconds(std::max(*n, 1u));
+                else if (auto n = value("attempts:", 5))
+                    config.attempts = std::max(*n, 1u);
+                else if (option == "edns0")
+                    config.edns0 = true;
+            }
+        }
+    }
+
+    if (config.nameservers.empty())
+        config.nameservers.push_back(address::from_ipv4(localhost, dns_port));
+
+    if (!has_search) {
+        char hostname[256] {};
+        if (::gethostname(hostname, sizeof(hostname) - 1) == 0) {
+            if (const char* domain = std::strchr(hostname, '.'); domain && domain[1] != '\0')
+                config.search.push_back(std::string(without_root(domain + 1)));
+        }
+    }
+    return config;
+}
+
+net::resolver::resolver()
+    : resolver(resolver_config::from_resolv_conf())
+{
+}
+
+net::resolver::resolver(resolver_config config, const char* hosts_path)
+    : m_config { std::move(config) }
+    , m_random { std::random_device {}() }
+{
+    if (m_config.nameservers.empty())
+        throw std::invalid_argument("a resolver needs at least one nameserver");
+    if (hosts_path)
+        load_hosts(hosts_path);
+
+    for (const address& server : m_config.nameservers) {
+        socket sock { server.family(), SOCK_DGRAM, 0 };
+        sock.setblocking(false);
+        // answers can then only come from the nameserver
+        sock.connect(server);
+        m_poller.add(sock.native_handle(), epoll::read);
+        m_udp.push_back(std::move(sock));
+    }
+}
+
+void net::resolver::load_hosts(const char* path)
+{
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        std::size_t comment = line.find('#');
+        if (comment != std::string::npos)
+            line.resize(comment);
+        std::istringstream words(line);
+        std::string text;
+        address addr;
+        if (!(words >> text) || !parse_address(text, 0, addr))
+            continue;
+
+        std::string canon_name;
+        for (std::string name; words >> name;) {
+            if (canon_name.empty())
+                canon_name = name;
+            m_hosts.emplace(lowercase(without_root(name)), host_entry { canon_name, addr });
+        }
+    }
+}
+
+net::resolver::query_id net::resolver::resolve(std::string_view host, std::uint16_t port, int family, int type, int protocol, int flags, callback done)
+{
+    query_id id = m_next_id++;
+    lookup l;
+    l.port = port;
+    l.family = family;
+    l.type = type;
+    l.protocol = protocol;
+    l.flags = flags;
+    l.done = std::move(done);
+
+    if (family != AF_UNSPEC && family != AF_INET && family != AF_INET6) {
+        m_finished.emplace_back(id, gai_error(EAI_FAMILY));
+    } else if (host.empty()) {
+        m_finished.emplace_back(id, gai_error(EAI_NONAME));
+    } else if (resolve_locally(l, host)) {
+        m_finished.emplace_back(id, l.addresses.empty() ? gai_error(EAI_NONAME) : std::error_code {});
+    } else {
+        // RFC 6761: keep the special use names off the wire, the loopback addresses answer them
+        std::string_view name = without_root(host);
+        if (equal_names(name, "localhost") || (name.size() > 10 && equal_names(name.substr(name.size() - 10), ".localhost"))) {
+            address loopback;
+            if (family != AF_INET && parse_address("::1", port, loopback))
+                l.addresses.push_back(loopback);
+            if (family != AF_INET6 && parse_address("127.0.0.1", port, loopback))
+                l.addresses.push_back(loopback);
+            l.canon_name = std::string(name);
+            m_finished.emplace_back(id, std::error_code {});
+        } else {
+            std::size_t dots = std::count(name.begin(), name.end(), '.');
+            bool absolute = host.back() == '.';
+            if (absolute || dots >= m_config.ndots)
+                l.names.emplace_back(name);
+            if (!absolute) {
+                for (const std::string& domain : m_config.search)
+                    l.names.push_back(std::string(name) + '.' + domain);
+                if (dots < m_config.ndots)
+                    l.names.emplace_back(name);
+            }
+        }
+    }
+
+    auto& inserted = m_lookups.emplace(id, std::move(l)).first->second;
+    if (!inserted.names.empty())
+        start_name(id, inserted);
+    deliver();
+    return id;
+}
+
+bool net::resolver::resolve_locally(lookup& l, std::string_view host)
+{
+    address numeric;
+    if (parse_address(host, l.port, numeric)) {
+        if (l.family == AF_UNSPEC || l.family == numeric.family())
+            l.addresses.push_back(numeric);
+        l.canon_name = std::string(host);
+        return true;
+    }
+    if (l.flags & AI_NUMERICHOST)
+        return true; // EAI_NONAME
+
+    auto [first, last] = m_hosts.equal_range(lowercase(without_root(host)));
+    if (first == last)
+        return false;
+    for (auto it = first; it != last; ++it) {
+        if (l.family != AF_UNSPEC && l.family != it->second.addr.family())
+            continue;
+        if (l.addresses.empty())
+            l.canon_name = it->second.canon_name;
+        l.addresses.push_back(with_port(it->second.addr, l.port));
+    }
+    // getaddrinfo gives the IPv6 addresses first
+    std::stable_partition(l.addresses.begin(), l.addresses.end(), [](const address& a) { return a.family() == AF_INET6; });
+    return true;
+}
+
+void net::resolver::start_name(query_id id, lookup& l)
+{
+    l.queries.clear();
+
+    std::uint16_t types[2];
+    std::size_t count = 0;
+    if (l.family != AF_INET)
+        types[count++] = type_aaaa;
+    if (l.family != AF_INET6)
+        types[count++] = type_a;
+
+    for (std::size_t i = 0; i < count; ++i) {
+        if (m_transactions.size() >= UINT16_MAX) {
+            l.queries.emplace_back(0, outcome::again);
+            continue;
+        }
+        std::uint16_t message_id;
+        do
+            message_id = static_cast<std::uint16_t>(m_random());
+        while (message_id == 0 || m_transactions.count(message_id));
+
+        transaction t;
+        t.owner = id;
+        t.qtype = types[i];
+        if (!encode_query(t.query, message_id, l.names[l.name], types[i], m_config.edns0)) {
+            l.queries.emplace_back(0, outcome::no_name);
+            continue;
+        }
+        transaction& stored = m_transactions.emplace(message_id, std::move(t)).first->second;
+        if (transmit(message_id, stored)) {
+            l.queries.emplace_back(message_id, outcome::pending);
+        } else {
+            m_transactions.erase(message_id);
+            l.queries.emplace_back(0, outcome::again);
+        }
+    }
+    settle(id, l);
+}
+
+bool net::resolver::transmit(std::uint16_t, transaction& t) noexcept
+{
+    std::size_t servers = m_udp.size();
+    while (t.transmissions < m_config.attempts * servers) {
+        std::size_t server = t.transmissions++ % servers;
+        std::error_code e;
+        m_udp[server].send(t.query.data(), t.query.size(), 0, e);
+        if (!e) {
+            t.deadline = clock::now() + m_config.timeout;
+            return true;
+        }
+    }
+    return false;
+}
+
+void net::resolver::start_tcp(std::uint16_t id, transaction& t, std::size_t server)
+{
+    t.tcp_buffer.clear();
+    write16(t.tcp_buffer, static_cast<std::uint16_t>(t.query.size()));
+    t.tcp_buffer.insert(t.tcp_buffer.end(), t.query.begin(), t.query.end());
+    t.tcp_offset = 0;
+    t.tcp_writing = true;
+
+    std::error_code e;
+    const address& addr = m_config.nameservers[server];
+    t.tcp = socket { addr.family(), SOCK_STREAM, 0, e };
+    if (!e)
+        t.tcp.setblocking(false, e);
+    if (!e) {
+        t.tcp.connect(addr, e);
+        if (in_progress(e))
+            e.assign(0, std::system_category());
+    }
+    if (!e && !m_poller.add(t.tcp.native_handle(), epoll::write, e))
+        e = std::make_error_code(std::errc::invalid_argument);
+    if (e) {
+        t.tcp = socket {};
+        if (!transmit(id, t))
+            finish_transaction(id, outcome::again);
+        return;
+    }
+    m_tcp[t.tcp.native_handle()] = id;
+    t.deadline = clock::now() + m_config.timeout;
+}
+
+void net::resolver::stop_tcp(transaction& t) noexcept
+{
+    if (!t.tcp)
+        return;
+    m_poller.remove(t.tcp.native_handle());
+    m_tcp.erase(t.tcp.native_handle());
+    t.tcp = socket {};
+}
+
+void net::resolver::process()
+{
+    std::error_code e;
+    process(e);
+    THROW_IF_ERROR(e);
+}
+
+void net::resolver::process(std::error_code& e)
+{
+    std::vector<std::pair<int, std::uint32_t>> events;
+    m_poller.execute(std::chrono::milliseconds::zero(), e);
+    if (e)
+        return;
+    m_poller.get(std::back_inserter(events));
+
+    for (auto [fd, flags] : events) {
+        auto udp = std::find_if(m_udp.begin(), m_udp.end(), [fd = fd](const socket& s) { return s.native_handle() == fd; });
+        if (udp != m_udp.end())
+            read_udp(*udp);
+        else
+            handle_tcp(fd, flags);
+    }
+
+    // retransmit to the next nameserver, or give up
+    auto now = clock::now();
+    std::vector<std::uint16_t> expired;
+    for (auto& [id, t] : m_transactions)
+        if (t.deadline <= now)
+            expired.push_back(id);
+    for (std::uint16_t id : expired) {
+        auto it = m_transactions.find(id);
+        if (it == m_transactions.end())
+            continue;
+        stop_tcp(it->second);
+        if (!transmit(id, it->second))
+            finish_transaction(id, outcome::again);
+    }
+
+    deliver();
+}
+
+void net::resolver::read_udp(socket& sock)
+{
+    unsigned char message[4096];
+    for (;;) {
+        std::error_code e;
+        std::size_t size = sock.recv(message, sizeof(message), MSG_DONTWAIT, e);
+        if (e == std::errc::connection_refused)
+            continue; // ICMP port unreachable from an earlier query, the timeout moves on
+        if (e)
+            return;
+        if (size < header_size)
+            continue;
+        handle_answer(read16(message), message, size, false);
+    }
+}
+
+void net::resolver::handle_tcp(socket::native_handle_type fd, std::uint32_t events)
+{
+    auto found = m_tcp.find(fd);
+    if (found == m_tcp.end())
+        return;
+    std::uint16_t id = found->second;
+    transaction& t = m_transactions.at(id);
+
+    auto retry = [&] {
+        stop_tcp(t);
+        if (!transmit(id, t))
+            finish_transaction(id, outcome::again);
+    };
+
+    std::error_code e;
+    if (t.tcp_writing) {
+        if (events & (EPOLLERR | EPOLLHUP)) {
+            retry();
+            return;
+        }
+        std::size_t sent = t.tcp.send(t.tcp_buffer.data() + t.tcp_offset, t.tcp_buffer.size() - t.tcp_offset, MSG_NOSIGNAL, e);
+        if (in_progress(e))
+            return;
+        if (e) {
+            retry();
+            return;
+        }
+        t.tcp_offset += sent;
+        if (t.tcp_offset == t.tcp_buffer.size()) {
+            t.tcp_writing = false;
+            t.tcp_offset = 0;
+            t.tcp_buffer.assign(2, 0);
+            m_poller.modify(fd, epoll::read);
+        }
+        return;
+    }
+
+    // a two byte length, then the message
+    for (;;) {
+        std::size_t received = t.tcp.recv(t.tcp_buffer.data() + t.tcp_offset, t.tcp_buffer.size() - t.tcp_offset, 0, e);
+        if (in_progress(e))
+            return;
+        if (e || received == 0) {
+            retry();
+            return;
+        }
+        t.tcp_offset += received;
+        if (t.tcp_offset < t.tcp_buffer.size())
+            continue;
+        if (t.tcp_buffer.size() > 2)
+            break;
+        std::size_t length = read16(t.tcp_buffer.data());
+        if (length < header_size) {
+            retry();
+            return;
+        }
+        t.tcp_buffer.resize(2 + length);
+    }
+
+    std::vector<unsigned char> message = std::move(t.tcp_buffer);
+    stop_tcp(t);
+    handle_answer(id, message.data() + 2, message.size() - 2, true);
+}
+
+void net::resolver::handle_answer(std::uint16_t id, const unsigned char* message, std::size_t size, bool tcp)
+{
+    auto found = m_transactions.find(id);
+    if (found == m_transactions.end())
+        return; // late, or not for us
+    transaction& t = found->second;
+    lookup& l = m_lookups.at(t.owner);
+
+    std::uint16_t flags = read16(message + 2);
+    std::uint16_t questions = read16(message + 4);
+    std::uint16_t answers = read16(message + 6);
+    if (!(flags & 0x8000) || questions != 1)
+        return;
+
+    std::size_t offset = header_size;
+    std::string name;
+    if (!read_name(message, size, offset, name) || offset + 4 > size)
+        return;
+    if (!equal_names(name, l.names[l.name]) || read16(message + offset) != t.qtype || read16(message + offset + 2) != class_in)
+        return; // an answer to another question
+    offset += 4;
+
+    if (flags & 0x0200) { // truncated
+        if (!tcp && !t.tcp) {
+            std::size_t server = (t.transmissions - 1) % m_udp.size();
+            start_tcp(id, t, server);
+        }
+        return;
+    }
+
+    switch (flags & 0x000f) {
+    case 0:
+        break;
+    case 3: // NXDOMAIN
+        finish_transaction(id, outcome::no_name);
+        return;
+    case 1: // FORMERR
+        finish_transaction(id, outcome::fail);
+        return;
+    default: // SERVFAIL, NOTIMP, REFUSED: next nameserver
+        stop_tcp(t);
+        if (!transmit(id, t))
+            finish_transaction(id, outcome::again);
+        return;
+    }
+
+    std::vector<record> records;
+    for (std::uint16_t i = 0; i < answers; ++i) {
+        record r;
+        if (!read_name(message, size, offset, r.name) || offset + 10 > size) {
+            finish_transaction(id, outcome::fail);
+            return;
+        }
+        r.type = read16(message + offset);
+        std::uint16_t rclass = read16(message + offset + 2);
+        r.data_size = read16(message + offset + 8);
+        r.data = offset + 10;
+        offset = r.data + r.data_size;
+        if (offset > size) {
+            finish_transaction(id, outcome::fail);
+            return;
+        }
+        if (rclass == class_in)
+            records.push_back(std::move(r));
+    }
+
+    // follow the CNAME chain from the name asked for, the records can come in any order
+    std::string target = l.names[l.name];
+    for (unsigned hops = 0; hops < max_cnames; ++hops) {
+        auto cname = std::find_if(records.begin(), records.end(), [&](const record& r) { return r.type == type_cname && equal_names(r.name, target); });
+        if (cname == records.end())
+            break;
+        std::size_t data = cname->data;
+        if (!read_name(message, size, data, target)) {
+            finish_transaction(id, outcome::fail);
+            return;
+        }
+    }
+
+    std::size_t before = l.addresses.size();
+    for (const record& r : records) {
+        if (r.type != t.qtype || !equal_names(r.name, target))
+            continue;
+        if (r.type == type_a && r.data_size == 4) {
+            sockaddr_in in {};
+            in.sin_family = AF_INET;
+            in.sin_port = htons(l.port);
+            std::memcpy(&in.sin_addr, message + r.data, 4);
+            l.addresses.emplace_back(reinterpret_cast<const sockaddr*>(&in), sizeof(in));
+        } else if (r.type == type_aaaa && r.data_size == 16) {
+            sockaddr_in6 in6 {};
+            in6.sin6_family = AF_INET6;
+            in6.sin6_port = htons(l.port);
+            std::memcpy(&in6.sin6_addr, message + r.data, 16);
+            l.addresses.emplace_back(reinterpret_cast<const sockaddr*>(&in6), sizeof(in6));
+        }
+    }
+    if (l.addresses.size() == before) {
+        finish_transaction(id, outcome::no_name); // NODATA
+        return;
+    }
+    if (l.canon_name.empty() || t.qtype == type_aaaa)
+        l.canon_name = std::string(without_root(target));
+    finish_transaction(id, outcome::answered);
+}
+
+void net::resolver::finish_transaction(std::uint16_t id, outcome result)
+{
+    auto found = m_transactions.find(id);
+    if (found == m_transactions.end())
+        return;
+    query_id owner = found->second.owner;
+    stop_tcp(found->second);
+    m_transactions.erase(found);
+
+    lookup& l = m_lookups.at(owner);
+    for (auto& [message_id, o] : l.queries) {
+        if (message_id == id) {
+            message_id = 0;
+            o = result;
+        }
+    }
+    settle(owner, l);
+}
+
+// once every query for the current name finished, completes the lookup or moves on to the next name
+void net::resolver::settle(query_id id, lookup& l)
+{
+    auto has = [&](outcome wanted) {
+        return std::any_of(l.queries.begin(), l.queries.end(), [&](const auto& q) { return q.second == wanted; });
+    };
+    if (has(outcome::pending))
+        return;
+
+    std::error_code e;
+    if (has(outcome::answered)) {
+        // getaddrinfo gives the IPv6 addresses first
+        std::stable_partition(l.addresses.begin(), l.addresses.end(), [](const address& a) { return a.family() == AF_INET6; });
+    } else if (has(outcome::again)) {
+        e = gai_error(EAI_AGAIN);
+    } else if (has(outcome::fail)) {
+        e = gai_error(EAI_FAIL);
+    } else if (++l.name < l.names.size()) {
+        start_name(id, l);
+        return;
+    } else {
+        e = gai_error(EAI_NONAME);
+    }
+    l.queries.clear();
+    m_finished.emplace_back(id, e);
+}
+
+void net::resolver::deliver()
+{
+    std::vector<std::pair<query_id, std::error_code>> finished;
+    finished.swap(m_finished);
+
+    for (auto& [id, e] : finished) {
+        auto found = m_lookups.find(id);
+        if (found == m_lookups.end())
+            continue; // cancelled
+        lookup l = std::move(found->second);
+        m_lookups.erase(found);
+
+        std::vector<address_info> results;
+        if (!e) {
+            // what getaddrinfo gives for a zero type
+            std::pair<int, int> kinds[] = { { SOCK_STREAM, IPPROTO_TCP }, { SOCK_DGRAM, IPPROTO_UDP }, { SOCK_RAW, 0 } };
+            std::size_t kind_count = 3;
+            if (l.type != 0) {
+                kinds[0] = { l.type, l.protocol ? l.protocol : l.type == SOCK_STREAM ? IPPROTO_TCP : l.type == SOCK_DGRAM ? IPPROTO_UDP : 0 };
+                kind_count = 1;
+            }
+            results.reserve(l.addresses.size() * kind_count);
+            for (const address& addr : l.addresses) {
+                for (std::size_t i = 0; i < kind_count; ++i) {
+                    const char* canon_name = results.empty() && (l.flags & AI_CANONNAME) ? l.canon_name.c_str() : nullptr;
+                    results.push_back(address_info(addr.family(), kinds[i].first, kinds[i].second,
+                        reinterpret_cast<const sockaddr*>(addr.address_pointer()), addr.address_size(), canon_name));
+                }
+            }
+        }
+        if (l.done)
+            l.done(e, std::move(results));
+    }
+}
+
+void net::resolver::cancel(query_id id) noexcept
+{
+    auto found = m_lookups.find(id);
+    if (found == m_lookups.end())
+        return;
+    for (const auto& [message_id, o] : found->second.queries) {
+        auto t = m_transactions.find(message_id);
+        if (t != m_transactions.end()) {
+            stop_tcp(t->second);
+            m_transactions.erase(t);
+        }
+    }
+    m_lookups.erase(found);
+}
+
+std::optional<std::chrono::milliseconds> net::resolver::remaining() const noexcept
+{
+    if (m_transactions.empty())
+        return std::nullopt;
+    auto next = std::min_element(m_transactions.begin(), m_transactions.end(), [](const auto& a, const auto& b) { return a.second.deadline < b.second.deadline; });
+    auto now = clock::now();
+    if (next->second.deadline <= now)
+        return std::chrono::milliseconds::zero();
+    return std::chrono::ceil<std::chrono::milliseconds>(next->second.deadline - now);
+}
+
+#endif
@@ -0,0 +1,114 @@
+#ifdef __linux__
+#include <cppnet/reuseport.hpp>
+
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#define THROW_IF_ERROR(e) \
+    if (e)                \
+    throw std::system_error(e)
+
+net::bpf_program net::reuseport_cpu_program(unsigned listeners)
+{
+    return {
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, static_cast<__u32>(SKF_AD_OFF + SKF_AD_CPU)), // A = cpu that received the packet
+        BPF_STMT(BPF_ALU | BPF_MOD | BPF_K, listeners), // A %= listeners
+        BPF_STMT(BPF_RET | BPF_A, 0), // return A
+    };
+}
+
+void net::attach_reuseport_cpu_steering(socket& sock, unsigned listeners)
+{
+    std::error_code e;
+    attach_reuseport_cpu_steering(sock, listeners, e);
+    THROW_IF_ERROR(e);
+}
+
+void net::attach_reuseport_cpu_steering(socket& sock, unsigned listeners, std::error_code& e) noexcept
+{
+    if (listeners == 0) {
+        e = std::make_error_code(std::errc::invalid_argument);
+        return;
+    }
+    try {
+        attach_reuseport_filter(sock, reuseport_cpu_program(listeners), e);
+    } catch (const std::bad_alloc&) {
+        e = std::make_error_code(std::errc::not_enough_memory);
+    }
+}
+
+std::vector<net::socket> net::reuseport_listeners(const address& addr, unsigned count, int backlog, int type)
+{
+    std::error_code e;
+    auto listeners = reuseport_listeners(addr, count, backlog, type, e);
+    THROW_IF_ERROR(e);
+    return listeners;
+}
+
+std::vector<net::socket> net::reuseport_listeners(const address& addr, unsigned count, int backlog, int type, std::error_code& e)
+{
+    std::vector<socket> listeners;
+    listeners.reserve(count);
+    for (unsigned i = 0; i < count; ++i) {
+        socket sock { addr.family(), type, 0, e };
+        if (e)
+            return {};
+
+        int enable = 1;
+        sock.setsockopt(SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable), e);
+        if (e)
+            return {};
+        // the program belongs to the group, attaching it before the first bind is enough
+        if (i == 0) {
+            attach_reuseport_cpu_steering(sock, count, e);
+            if (e)
+                return {};
+        }
+        sock.bind(addr, e);
+        if (e)
+            return {};
+        if (type == SOCK_STREAM) {
+            sock.listen(backlog, e);
+            if (e)
+                return {};
+        }
+        listeners.push_back(std::move(sock));
+    }
+    return listeners;
+}
+
+unsigned net::cpu_count() noexcept
+{
+    long count = ::sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? static_cast<unsigned>(count) : 1;
+}
+
+unsigned net::current_cpu() noexcept
+{
+    int cpu = ::sched_getcpu();
+    return cpu < 0 ? 0 : static_cast<unsigned>(cpu);
+}
+
+void net::pin_thread_to_cpu(unsigned cpu)
+{
+    std::error_code e;
+    pin_thread_to_cpu(cpu, e);
+    THROW_IF_ERROR(e);
+}
+
+void net::pin_thread_to_cpu(unsigned cpu, std::error_code& e) noexcept
+{
+    if (cpu >= CPU_SETSIZE) {
+        e = std::make_error_code(std::errc::invalid_argument);
+        return;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    // returns the error instead of setting errno
+    int r = ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set);
+    e.assign(r, std::system_category());
+}
+
+#endif
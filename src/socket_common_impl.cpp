@@ -71,6 +71,40 @@ size_t net::socket::sendto(const void* buffer, size_t size, int flags, const soc
     return sent;
 }
 
+#ifndef _WIN32
+size_t net::socket::recvmsg(msghdr* message, int flags)
+{
+    std::error_code e;
+    size_t received = recvmsg(message, flags, e);
+    THROW_IF_ERROR(e);
+    return received;
+}
+
+size_t net::socket::sendmsg(const msghdr* message, int flags)
+{
+    std::error_code e;
+    size_t sent = sendmsg(message, flags, e);
+    THROW_IF_ERROR(e);
+    return sent;
+}
+
+size_t net::socket::send_fds(const native_handle_type* handles, size_t count, const void* buffer, size_t size, int flags)
+{
+    std::error_code e;
+    size_t sent = send_fds(handles, count, buffer, size, flags, e);
+    THROW_IF_ERROR(e);
+    return sent;
+}
+
+size_t net::socket::recv_fds(void* buffer, size_t size, socket* sockets, size_t max_sockets, size_t* received, int flags)
+{
+    std::error_code e;
+    size_t received_bytes = recv_fds(buffer, size, sockets, max_sockets, received, flags, e);
+    THROW_IF_ERROR(e);
+    return received_bytes;
+}
+#endif
+
 void net::socket::connect(const sockaddr* addr, size_t len)
 {
     std::error_code e;
@@ -1,5 +1,6 @@
 #include <cppnet/socket.hpp>
 
+#include <cstring>
 #include <fcntl.h>
 #include <unistd.h>
 
@@ -89,6 +90,93 @@ size_t net::socket::sendto(const void* buffer, size_t size, int flags, const soc
     return sent;
 }
 
+size_t net::socket::recvmsg(msghdr* message, int flags, std::error_code& e) noexcept
+{
+    ssize_t received = ::recvmsg(m_handle, message, flags);
+    if (received < 0)
+        ASSIGN_ERRNO(e);
+    else
+        ASSIGN_ZERO(e);
+    return received;
+}
+
+size_t net::socket::sendmsg(const msghdr* message, int flags, std::error_code& e) noexcept
+{
+    ssize_t sent = ::sendmsg(m_handle, message, flags);
+    if (sent < 0)
+        ASSIGN_ERRNO(e);
+    else
+        ASSIGN_ZERO(e);
+    return sent;
+}
+
+size_t net::socket::send_fds(const native_handle_type* handles, size_t count, const void* buffer, size_t size, int flags, std::error_code& e) noexcept
+{
+    if (count > max_fds || size == 0) {
+        e = std::make_error_code(std::errc::invalid_argument);
+        return 0;
+    }
+
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(native_handle_type) * max_fds)];
+    iovec iov { const_cast<void*>(buffer), size };
+    msghdr message {};
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    if (count) {
+        message.msg_control = control;
+        message.msg_controllen = CMSG_SPACE(sizeof(native_handle_type) * count);
+        cmsghdr* cmsg = CMSG_FIRSTHDR(&message);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(native_handle_type) * count);
+        std::memcpy(CMSG_DATA(cmsg), handles, sizeof(native_handle_type) * count);
+    }
+    return sendmsg(&message, flags, e);
+}
+
+size_t net::socket::recv_fds(void* buffer, size_t size, socket* sockets, size_t max_sockets, size_t* received, int flags, std::error_code& e) noexcept
+{
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(native_handle_type) * max_fds)];
+    iovec iov { buffer, size };
+    msghdr message {};
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+
+    if (received)
+        *received = 0;
+#ifdef MSG_CMSG_CLOEXEC
+    flags |= MSG_CMSG_CLOEXEC;
+#endif
+    size_t received_bytes = recvmsg(&message, flags, e);
+    if (e)
+        return 0;
+
+    size_t stored = 0;
+    bool truncated = message.msg_flags & MSG_CTRUNC;
+    for (cmsghdr* cmsg = CMSG_FIRSTHDR(&message); cmsg != nullptr; cmsg = CMSG_NXTHDR(&message, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+            continue;
+        size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(native_handle_type);
+        for (size_t i = 0; i < count; ++i) {
+            native_handle_type handle;
+            std::memcpy(&handle, CMSG_DATA(cmsg) + i * sizeof(handle), sizeof(handle));
+            if (stored < max_sockets)
+                sockets[stored++] = socket { from_native_handle, handle };
+            else {
+                ::close(handle);
+                truncated = true;
+            }
+        }
+    }
+    if (received)
+        *received = stored;
+    if (truncated)
+        e = std::make_error_code(std::errc::message_size);
+    return received_bytes;
+}
+
 void net::socket::connect(const sockaddr* addr, size_t addrlen, std::error_code& e) noexcept
 {
     if (::connect(m_handle, addr, addrlen) < 0)
@@ -198,7 +286,7 @@ void net::socket::close(std::error_code& e) noexcept
 net::address net::socket::getsockname(std::error_code& e) noexcept
 {
     sockaddr_storage addr;
-    socklen_t addr_len;
+    socklen_t addr_len = sizeof(addr);
     int ret = ::getsockname(m_handle, reinterpret_cast<sockaddr*>(&addr), &addr_len);
     if (ret < 0) {
         ASSIGN_ERRNO(e);
@@ -210,7 +298,7 @@ net::address net::socket::getsockname(std::error_code& e) noexcept
 net::address net::socket::getpeername(std::error_code& e) noexcept
 {
     sockaddr_storage addr;
-    socklen_t addr_len;
+    socklen_t addr_len = sizeof(addr);
     int ret = ::getpeername(m_handle, reinterpret_cast<sockaddr*>(&addr), &addr_len);
     if (ret < 0) {
         ASSIGN_ERRNO(e);
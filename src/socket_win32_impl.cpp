@@ -82,7 +82,7 @@ int net::socket::family(std::error_code& e) const noexcept
 net::address net::socket::getsockname(std::error_code& e) noexcept
 {
     sockaddr_storage addr;
-    int addr_len;
+    int addr_len = sizeof(addr);
     int ret = ::getsockname(m_handle, reinterpret_cast<sockaddr*>(&addr), &addr_len);
     if (ret < 0) {
         ASSIGN_LAST_ERROR(e);
@@ -96,7 +96,7 @@ net::address net::socket::getsockname(std::error_code& e) noexcept
 net::address net::socket::getpeername(std::error_code& e) noexcept
 {
     sockaddr_storage addr;
-    int addr_len;
+    int addr_len = sizeof(addr);
     int ret = ::getpeername(m_handle, reinterpret_cast<sockaddr*>(&addr), &addr_len);
     if (ret < 0) {
         ASSIGN_LAST_ERROR(e);
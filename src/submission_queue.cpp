@@ -0,0 +1,43 @@
+#ifdef __linux__
+#include <cppnet/submission_queue.hpp>
+
+#include <cerrno>
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+net::doorbell::doorbell()
+    : m_handle { ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC) }
+{
+    if (m_handle < 0)
+        throw std::system_error(errno, std::system_category());
+}
+
+net::doorbell::doorbell(std::error_code& e) noexcept
+    : m_handle { ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC) }
+{
+    if (m_handle < 0)
+        e.assign(errno, std::system_category());
+    else
+        e.assign(0, std::system_category());
+}
+
+net::doorbell::~doorbell() noexcept
+{
+    if (m_handle != -1)
+        ::close(m_handle);
+}
+
+void net::doorbell::ring() noexcept
+{
+    std::uint64_t one = 1;
+    [[maybe_unused]] auto ignored = ::write(m_handle, &one, sizeof(one));
+}
+
+void net::doorbell::reset() noexcept
+{
+    std::uint64_t count;
+    [[maybe_unused]] auto ignored = ::read(m_handle, &count, sizeof(count));
+}
+
+#endif
@@ -0,0 +1,77 @@
+#ifdef __linux__
+#include <cppnet/tcp_info.hpp>
+
+#include <cstddef>
+
+#include <linux/tcp.h>
+
+namespace {
+
+// the running kernel may know fewer fields than the headers we were built with
+constexpr bool has_field(socklen_t len, std::size_t offset, std::size_t size) noexcept
+{
+    return offset + size <= len;
+}
+
+#define HAS_FIELD(len, field) has_field(len, offsetof(::tcp_info, field), sizeof(::tcp_info::field))
+
+}
+
+net::tcp_stats net::tcp_info(const socket& sock)
+{
+    std::error_code e;
+    tcp_stats stats = tcp_info(sock.native_handle(), e);
+    if (e)
+        throw std::system_error(e);
+    return stats;
+}
+
+net::tcp_stats net::tcp_info(const socket& sock, std::error_code& e) noexcept
+{
+    return tcp_info(sock.native_handle(), e);
+}
+
+net::tcp_stats net::tcp_info(socket::native_handle_type fd, std::error_code& e) noexcept
+{
+    ::tcp_info info {};
+    socklen_t len = sizeof(info);
+    if (::getsockopt(fd, IPPROTO_TCP, TCP_INFO, &info, &len) < 0) {
+        e.assign(errno, std::system_category());
+        return {};
+    }
+    e.assign(0, std::system_category());
+
+    tcp_stats stats {};
+    stats.state = info.tcpi_state;
+    stats.ca_state = info.tcpi_ca_state;
+    stats.rtt = std::chrono::microseconds(info.tcpi_rtt);
+    stats.rttvar = std::chrono::microseconds(info.tcpi_rttvar);
+    stats.rto = std::chrono::microseconds(info.tcpi_rto);
+    stats.mss = info.tcpi_snd_mss;
+    stats.cwnd = info.tcpi_snd_cwnd;
+    stats.ssthresh = info.tcpi_snd_ssthresh;
+    stats.retransmits = info.tcpi_retransmits;
+    stats.total_retransmits = info.tcpi_total_retrans;
+    stats.lost = info.tcpi_lost;
+    stats.unacked = info.tcpi_unacked;
+
+    if (HAS_FIELD(len, tcpi_min_rtt))
+        stats.min_rtt = std::chrono::microseconds(info.tcpi_min_rtt);
+    if (HAS_FIELD(len, tcpi_notsent_bytes))
+        stats.notsent_bytes = info.tcpi_notsent_bytes;
+    if (HAS_FIELD(len, tcpi_bytes_acked))
+        stats.bytes_acked = info.tcpi_bytes_acked;
+    if (HAS_FIELD(len, tcpi_bytes_received))
+        stats.bytes_received = info.tcpi_bytes_received;
+    if (HAS_FIELD(len, tcpi_delivery_rate))
+        stats.delivery_rate = info.tcpi_delivery_rate;
+    if (HAS_FIELD(len, tcpi_bytes_retrans)) {
+        // bytes_sent counts retransmissions too
+        std::uint64_t unique_sent = info.tcpi_bytes_sent - info.tcpi_bytes_retrans;
+        if (unique_sent > info.tcpi_bytes_acked)
+            stats.unacked_bytes = unique_sent - info.tcpi_bytes_acked;
+    }
+    return stats;
+}
+
+#endif
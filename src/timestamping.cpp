@@ -0,0 +1,213 @@
+#ifdef __linux__
+#include <cppnet/timestamping.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+#include <linux/errqueue.h>
+#include <sys/uio.h>
+
+namespace {
+
+constexpr std::size_t control_buffer_size = 512;
+
+std::chrono::nanoseconds to_nanoseconds(const timespec& ts) noexcept
+{
+    return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+}
+
+// fills timestamp with every control message it understands, returns true if a sock_extended_err was found
+bool parse_control_messages(msghdr& message, net::packet_timestamp& timestamp) noexcept
+{
+    bool extended_error = false;
+    for (cmsghdr* cmsg = CMSG_FIRSTHDR(&message); cmsg != nullptr; cmsg = CMSG_NXTHDR(&message, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPING) {
+            scm_timestamping ts;
+            std::memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+            timestamp.software = to_nanoseconds(ts.ts[0]);
+            timestamp.hardware = to_nanoseconds(ts.ts[2]);
+        } else if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+            timespec ts;
+            std::memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+            timestamp.software = to_nanoseconds(ts);
+        } else if ((cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR)
+            || (cmsg->cmsg_level == SOL_IPV6 && cmsg->cmsg_type == IPV6_RECVERR)) {
+            sock_extended_err err;
+            std::memcpy(&err, CMSG_DATA(cmsg), sizeof(err));
+            if (err.ee_errno != ENOMSG || err.ee_origin != SO_EE_ORIGIN_TIMESTAMPING)
+                continue;
+            extended_error = true;
+            timestamp.key = err.ee_data;
+            switch (err.ee_info) {
+            case SCM_TSTAMP_SCHED: timestamp.kind = net::packet_timestamp::scheduled; break;
+            case SCM_TSTAMP_SND: timestamp.kind = net::packet_timestamp::sent; break;
+            case SCM_TSTAMP_ACK: timestamp.kind = net::packet_timestamp::acknowledged; break;
+            }
+        }
+    }
+    return extended_error;
+}
+
+}
+
+void net::enable_timestamping(socket& sock, unsigned flags)
+{
+    std::error_code e;
+    enable_timestamping(sock, flags, e);
+    if (e)
+        throw std::system_error(e);
+}
+
+void net::enable_timestamping(socket& sock, unsigned flags, std::error_code& e) noexcept
+{
+    sock.setsockopt(SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags), e);
+}
+
+void net::enable_receive_timestamps(socket& sock)
+{
+    std::error_code e;
+    enable_receive_timestamps(sock, e);
+    if (e)
+        throw std::system_error(e);
+}
+
+void net::enable_receive_timestamps(socket& sock, std::error_code& e) noexcept
+{
+    int enable = 1;
+    sock.setsockopt(SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable), e);
+}
+
+size_t net::recv_timestamped(socket& sock, void* buffer, size_t buffer_size, int flags, packet_timestamp& timestamp, address* from)
+{
+    std::error_code e;
+    size_t received = recv_timestamped(sock, buffer, buffer_size, flags, timestamp, from, e);
+    if (e)
+        throw std::system_error(e);
+    return received;
+}
+
+size_t net::recv_timestamped(socket& sock, void* buffer, size_t buffer_size, int flags, packet_timestamp& timestamp, address* from, std::error_code& e) noexcept
+{
+    iovec iov { buffer, buffer_size };
+    sockaddr_storage addr {};
+    alignas(cmsghdr) char control[control_buffer_size];
+
+    msghdr message {};
+    message.msg_name = from ? &addr : nullptr;
+    message.msg_namelen = from ? sizeof(addr) : 0;
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+
+    size_t received = sock.recvmsg(&message, flags, e);
+    if (e)
+        return 0;
+
+    timestamp = packet_timestamp {};
+    parse_control_messages(message, timestamp);
+    if (from)
+        *from = address { reinterpret_cast<const sockaddr*>(&addr), message.msg_namelen };
+    return received;
+}
+
+bool net::recv_tx_timestamp(socket& sock, packet_timestamp& timestamp)
+{
+    std::error_code e;
+    bool received = recv_tx_timestamp(sock, timestamp, e);
+    if (e)
+        throw std::system_error(e);
+    return received;
+}
+
+bool net::recv_tx_timestamp(socket& sock, packet_timestamp& timestamp, std::error_code& e) noexcept
+{
+    // without opt_tsonly the kernel loops the packet back, we don't need it
+    char data[1];
+    iovec iov { data, sizeof(data) };
+    alignas(cmsghdr) char control[control_buffer_size];
+
+    for (;;) {
+        msghdr message {};
+        message.msg_iov = &iov;
+        message.msg_iovlen = 1;
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+
+        sock.recvmsg(&message, MSG_ERRQUEUE | MSG_DONTWAIT, e);
+        if (e == std::errc::resource_unavailable_try_again || e == std::errc::operation_would_block) {
+            e.assign(0, std::system_category());
+            return false;
+        } else if (e)
+            return false;
+
+        timestamp = packet_timestamp {};
+        if (parse_control_messages(message, timestamp))
+            return true;
+        // not a timestamp (e.g. an ICMP error), skip it
+    }
+}
+
+const net::tx_timestamp_tracker::record& net::tx_timestamp_tracker::on_send(std::size_t bytes)
+{
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    return on_send(bytes, std::chrono::duration_cast<std::chrono::nanoseconds>(now));
+}
+
+const net::tx_timestamp_tracker::record& net::tx_timestamp_tracker::on_send(std::size_t bytes, std::chrono::nanoseconds submitted)
+{
+    record r {};
+    r.first_byte = m_next_byte;
+    r.size = bytes;
+    r.submitted = submitted;
+    if (m_stream) {
+        // the kernel reports the offset of the last byte of the send
+        m_next_byte += bytes;
+        r.key = static_cast<std::uint32_t>(m_next_byte - 1);
+    } else {
+        ++m_next_byte;
+        r.key = m_next_key++;
+    }
+    return m_pending.emplace_back(r);
+}
+
+const net::tx_timestamp_tracker::record* net::tx_timestamp_tracker::on_timestamp(const packet_timestamp& timestamp) noexcept
+{
+    auto it = std::find_if(m_pending.begin(), m_pending.end(), [&](const record& r) {
+        return r.key == timestamp.key;
+    });
+    if (it == m_pending.end())
+        return nullptr;
+
+    auto time = timestamp.hardware.count() ? timestamp.hardware : timestamp.software;
+    switch (timestamp.kind) {
+    case packet_timestamp::scheduled: it->scheduled = time; break;
+    case packet_timestamp::sent: it->sent = time; break;
+    case packet_timestamp::acknowledged: it->acknowledged = time; break;
+    case packet_timestamp::received: break;
+    }
+    return &*it;
+}
+
+std::optional<net::tx_timestamp_tracker::record> net::tx_timestamp_tracker::pop()
+{
+    if (m_pending.empty())
+        return std::nullopt;
+
+    const record& front = m_pending.front();
+    std::chrono::nanoseconds done {};
+    switch (m_completion) {
+    case packet_timestamp::scheduled: done = front.scheduled; break;
+    case packet_timestamp::sent: done = front.sent; break;
+    case packet_timestamp::acknowledged: done = front.acknowledged; break;
+    case packet_timestamp::received: break;
+    }
+    if (!done.count())
+        return std::nullopt;
+
+    record r = front;
+    m_pending.pop_front();
+    return r;
+}
+
+#endif
@@ -0,0 +1,357 @@
+#include <cppnet/tls.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <utility>
+
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#define THROW_IF_ERROR(e) \
+    if (e)                \
+    throw std::system_error(e)
+
+namespace {
+
+class tls_error_category_t : public std::error_category {
+public:
+    const char* name() const noexcept override
+    {
+        return "tls";
+    }
+
+    std::string message(int ecode) const override
+    {
+        char buffer[256];
+        ERR_error_string_n(static_cast<unsigned long>(static_cast<unsigned>(ecode)), buffer, sizeof(buffer));
+        return buffer;
+    }
+};
+
+const tls_error_category_t tls_error_category {};
+
+// the oldest error of the thread's OpenSSL error queue, which is then emptied
+std::error_code last_error() noexcept
+{
+    unsigned long code = ERR_get_error();
+    ERR_clear_error();
+    if (code == 0)
+        return std::make_error_code(std::errc::protocol_error);
+    return { static_cast<int>(code), tls_error_category };
+}
+
+// for what an SSL_* function that returned result failed
+std::error_code operation_error(SSL* ssl, int result) noexcept
+{
+    switch (SSL_get_error(ssl, result)) {
+    case SSL_ERROR_WANT_READ:
+    case SSL_ERROR_WANT_WRITE:
+        return std::make_error_code(std::errc::operation_would_block);
+    case SSL_ERROR_ZERO_RETURN:
+        return {};
+    case SSL_ERROR_SYSCALL:
+        ERR_clear_error();
+        if (errno)
+            return { errno, std::system_category() };
+        return std::make_error_code(std::errc::connection_reset);
+    default:
+        return last_error();
+    }
+}
+
+}
+
+const std::error_category& net::tls::category() noexcept
+{
+    return tls_error_category;
+}
+
+net::tls::context::context(role r)
+    : m_role { r }
+{
+    m_ctx = SSL_CTX_new(r == role::client ? TLS_client_method() : TLS_server_method());
+    if (!m_ctx)
+        throw std::system_error(last_error());
+
+    SSL_CTX_set_min_proto_version(m_ctx, TLS1_2_VERSION);
+    SSL_CTX_set_options(m_ctx, SSL_OP_ENABLE_KTLS);
+    SSL_CTX_set_mode(m_ctx, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+    if (r == role::client) {
+        SSL_CTX_set_default_verify_paths(m_ctx);
+        verify_peer(true);
+    }
+}
+
+net::tls::context::~context() noexcept
+{
+    SSL_CTX_free(m_ctx);
+}
+
+void net::tls::context::use_certificate_chain_file(const std::string& path)
+{
+    std::error_code e;
+    use_certificate_chain_file(path, e);
+    THROW_IF_ERROR(e);
+}
+
+void net::tls::context::use_certificate_chain_file(const std::string& path, std::error_code& e) noexcept
+{
+    ERR_clear_error();
+    if (SSL_CTX_use_certificate_chain_file(m_ctx, path.c_str()) != 1)
+        e = last_error();
+    else
+        e.clear();
+}
+
+void net::tls::context::use_private_key_file(const std::string& path)
+{
+    std::error_code e;
+    use_private_key_file(path, e);
+    THROW_IF_ERROR(e);
+}
+
+void net::tls::context::use_private_key_file(const std::string& path, std::error_code& e) noexcept
+{
+    ERR_clear_error();
+    if (SSL_CTX_use_PrivateKey_file(m_ctx, path.c_str(), SSL_FILETYPE_PEM) != 1 || SSL_CTX_check_private_key(m_ctx) != 1)
+        e = last_error();
+    else
+        e.clear();
+}
+
+void net::tls::context::load_verify_file(const std::string& path)
+{
+    std::error_code e;
+    load_verify_file(path, e);
+    THROW_IF_ERROR(e);
+}
+
+void net::tls::context::load_verify_file(const std::string& path, std::error_code& e) noexcept
+{
+    ERR_clear_error();
+    if (SSL_CTX_load_verify_locations(m_ctx, path.c_str(), nullptr) != 1)
+        e = last_error();
+    else
+        e.clear();
+}
+
+void net::tls::context::verify_peer(bool enabled) noexcept
+{
+    int mode = SSL_VERIFY_NONE;
+    if (enabled)
+        mode = m_role == role::client ? SSL_VERIFY_PEER : SSL_VERIFY_PEER | SSL_VERIFY_FAIL_IF_NO_PEER_CERT;
+    SSL_CTX_set_verify(m_ctx, mode, nullptr);
+}
+
+net::tls::stream::stream(context& ctx, net::socket sock)
+    : m_socket { std::move(sock) }
+{
+    m_ssl = SSL_new(ctx.native_handle());
+    if (!m_ssl)
+        throw std::system_error(last_error());
+    if (SSL_set_fd(m_ssl, static_cast<int>(m_socket.native_handle())) != 1) {
+        SSL_free(m_ssl);
+        throw std::system_error(last_error());
+    }
+    if (ctx.side() == context::role::client)
+        SSL_set_connect_state(m_ssl);
+    else
+        SSL_set_accept_state(m_ssl);
+}
+
+net::tls::stream::stream(stream&& rhs) noexcept
+    : m_socket { std::move(rhs.m_socket) }
+    , m_ssl { std::exchange(rhs.m_ssl, nullptr) }
+{
+}
+
+net::tls::stream& net::tls::stream::operator=(stream&& rhs) noexcept
+{
+    std::swap(m_ssl, rhs.m_ssl);
+    std::swap(m_socket, rhs.m_socket);
+    return *this;
+}
+
+net::tls::stream::~stream() noexcept
+{
+    SSL_free(m_ssl);
+}
+
+void net::tls::stream::set_server_name(const std::string& name)
+{
+    std::error_code e;
+    set_server_name(name, e);
+    THROW_IF_ERROR(e);
+}
+
+void net::tls::stream::set_server_name(const std::string& name, std::error_code& e) noexcept
+{
+    ERR_clear_error();
+    if (SSL_set_tlsext_host_name(m_ssl, name.c_str()) != 1 || SSL_set1_host(m_ssl, name.c_str()) != 1)
+        e = last_error();
+    else
+        e.clear();
+}
+
+void net::tls::stream::handshake()
+{
+    std::error_code e;
+    handshake(e);
+    THROW_IF_ERROR(e);
+}
+
+void net::tls::stream::handshake(std::error_code& e) noexcept
+{
+    ERR_clear_error();
+    int result = SSL_do_handshake(m_ssl);
+    if (result == 1) {
+        e.clear();
+        return;
+    }
+    e = operation_error(m_ssl, result);
+    if (!e)
+        e = std::make_error_code(std::errc::connection_reset); // closed in the middle of it
+}
+
+std::size_t net::tls::stream::send(const void* buffer, std::size_t size)
+{
+    std::error_code e;
+    std::size_t sent = send(buffer, size, e);
+    THROW_IF_ERROR(e);
+    return sent;
+}
+
+std::size_t net::tls::stream::send(const void* buffer, std::size_t size, std::error_code& e) noexcept
+{
+    ERR_clear_error();
+    std::size_t sent = 0;
+    int result = SSL_write_ex(m_ssl, buffer, size, &sent);
+    if (result == 1) {
+        e.clear();
+        return sent;
+    }
+    e = operation_error(m_ssl, result);
+    if (!e)
+        e = std::make_error_code(std::errc::broken_pipe); // after close_notify
+    return 0;
+}
+
+std::size_t net::tls::stream::recv(void* buffer, std::size_t size)
+{
+    std::error_code e;
+    std::size_t received = recv(buffer, size, e);
+    THROW_IF_ERROR(e);
+    return received;
+}
+
+std::size_t net::tls::stream::recv(void* buffer, std::size_t size, std::error_code& e) noexcept
+{
+    ERR_clear_error();
+    std::size_t received = 0;
+    int result = SSL_read_ex(m_ssl, buffer, size, &received);
+    if (result == 1) {
+        e.clear();
+        return received;
+    }
+    // a clean close, with close_notify, is no error
+    e = operation_error(m_ssl, result);
+    return 0;
+}
+
+#ifndef _WIN32
+std::size_t net::tls::stream::sendfile(int fd, std::int64_t offset, std::size_t size)
+{
+    std::error_code e;
+    std::size_t sent = sendfile(fd, offset, size, e);
+    THROW_IF_ERROR(e);
+    return sent;
+}
+
+std::size_t net::tls::stream::sendfile(int fd, std::int64_t offset, std::size_t size, std::error_code& e) noexcept
+{
+    e.clear();
+#ifndef OPENSSL_NO_KTLS
+    if (ktls_send()) {
+        ERR_clear_error();
+        ossl_ssize_t sent = SSL_sendfile(m_ssl, fd, static_cast<off_t>(offset), size, 0);
+        if (sent < 0) {
+            e = operation_error(m_ssl, static_cast<int>(sent));
+            return 0;
+        }
+        return static_cast<std::size_t>(sent);
+    }
+#endif
+
+    char buffer[16 * 1024];
+    std::size_t total = 0;
+    while (total < size) {
+        ssize_t read = ::pread(fd, buffer, std::min(sizeof(buffer), size - total), static_cast<off_t>(offset + total));
+        if (read < 0) {
+            if (errno == EINTR)
+                continue;
+            e.assign(errno, std::system_category());
+            break;
+        }
+        if (read == 0)
+            break; // the end of the file
+        std::size_t written = 0;
+        while (written < static_cast<std::size_t>(read) && !e)
+            written += send(buffer + written, static_cast<std::size_t>(read) - written, e);
+        total += written;
+        if (e)
+            break;
+    }
+    return total;
+}
+#endif
+
+void net::tls::stream::shutdown()
+{
+    std::error_code e;
+    shutdown(e);
+    THROW_IF_ERROR(e);
+}
+
+void net::tls::stream::shutdown(std::error_code& e) noexcept
+{
+    ERR_clear_error();
+    int result = SSL_shutdown(m_ssl);
+    // 0 when the peer's close_notify hasn't come yet, which isn't waited for
+    if (result >= 0)
+        e.clear();
+    else
+        e = operation_error(m_ssl, result);
+}
+
+bool net::tls::stream::ktls_send() const noexcept
+{
+#ifndef OPENSSL_NO_KTLS
+    return BIO_get_ktls_send(SSL_get_wbio(m_ssl));
+#else
+    return false;
+#endif
+}
+
+bool net::tls::stream::ktls_recv() const noexcept
+{
+#ifndef OPENSSL_NO_KTLS
+    return BIO_get_ktls_recv(SSL_get_rbio(m_ssl));
+#else
+    return false;
+#endif
+}
+
+std::string_view net::tls::stream::version() const noexcept
+{
+    return SSL_get_version(m_ssl);
+}
+
+std::string_view net::tls::stream::cipher() const noexcept
+{
+    const char* name = SSL_get_cipher_name(m_ssl);
+    return name ? name : "";
+}
@@ -0,0 +1,602 @@
+#include <cppnet/websocket.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/uio.h>
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define CPPNET_WEBSOCKET_SSE2
+#include <emmintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define CPPNET_WEBSOCKET_AVX2
+#include <immintrin.h>
+#endif
+#endif
+
+#define THROW_IF_ERROR(e) \
+    if (e)                \
+    throw std::system_error(e)
+
+namespace {
+
+class websocket_error_category_t : public std::error_category {
+public:
+    const char* name() const noexcept override
+    {
+        return "websocket";
+    }
+
+    std::string message(int ecode) const override
+    {
+        switch (static_cast<net::websocket::errc>(ecode)) {
+        case net::websocket::errc::bad_frame:
+            return "malformed frame";
+        case net::websocket::errc::bad_opcode:
+            return "unknown opcode";
+        case net::websocket::errc::bad_control_frame:
+            return "fragmented or oversized control frame";
+        case net::websocket::errc::bad_continuation:
+            return "unexpected continuation frame";
+        case net::websocket::errc::bad_masking:
+            return "frame masked the wrong way for its direction";
+        case net::websocket::errc::message_too_big:
+            return "message too big";
+        case net::websocket::errc::bad_handshake:
+            return "invalid opening handshake";
+        }
+        return "unknown websocket error";
+    }
+};
+
+const websocket_error_category_t websocket_error_category {};
+
+// key is the 4 mask bytes, as they are in memory, starting with the one for p[0]
+
+void mask_scalar(unsigned char* p, std::size_t size, std::uint32_t key) noexcept
+{
+    std::uint64_t key64 = static_cast<std::uint64_t>(key) << 32 | key;
+    for (; size >= 8; p += 8, size -= 8) {
+        std::uint64_t word;
+        std::memcpy(&word, p, 8);
+        word ^= key64;
+        std::memcpy(p, &word, 8);
+    }
+    unsigned char bytes[4];
+    std::memcpy(bytes, &key, 4);
+    for (std::size_t i = 0; i < size; ++i)
+        p[i] ^= bytes[i & 3];
+}
+
+#ifdef CPPNET_WEBSOCKET_SSE2
+void mask_sse2(unsigned char* p, std::size_t size, std::uint32_t key) noexcept
+{
+    const __m128i k = _mm_set1_epi32(static_cast<int>(key));
+    for (; size >= 16; p += 16, size -= 16) {
+        __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p), _mm_xor_si128(data, k));
+    }
+    mask_scalar(p, size, key);
+}
+#endif
+
+#ifdef CPPNET_WEBSOCKET_AVX2
+__attribute__((target("avx2"))) void mask_avx2(unsigned char* p, std::size_t size, std::uint32_t key) noexcept
+{
+    const __m256i k = _mm256_set1_epi32(static_cast<int>(key));
+    for (; size >= 64; p += 64, size -= 64) {
+        __m256i first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i second = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), _mm256_xor_si256(first, k));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(p + 32), _mm256_xor_si256(second, k));
+    }
+    if (size >= 32) {
+        __m256i data = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), _mm256_xor_si256(data, k));
+        p += 32;
+        size -= 32;
+    }
+    mask_sse2(p, size, key);
+}
+#endif
+
+using masker = void (*)(unsigned char*, std::size_t, std::uint32_t) noexcept;
+
+masker select_masker() noexcept
+{
+#ifdef CPPNET_WEBSOCKET_AVX2
+    if (__builtin_cpu_supports("avx2"))
+        return mask_avx2;
+#endif
+#ifdef CPPNET_WEBSOCKET_SSE2
+    return mask_sse2;
+#else
+    return mask_scalar;
+#endif
+}
+
+const masker mask_bytes = select_masker();
+
+// SHA-1, RFC 3174, only for the handshake
+
+class sha1 {
+public:
+    void update(std::string_view data) noexcept
+    {
+        m_length += data.size();
+        for (char c : data) {
+            m_block[m_used++] = static_cast<unsigned char>(c);
+            if (m_used == 64)
+                process();
+        }
+    }
+
+    std::array<unsigned char, 20> finish() noexcept
+    {
+        std::uint64_t bits = m_length * 8;
+        m_block[m_used++] = 0x80;
+        if (m_used > 56) {
+            std::fill(m_block.begin() + m_used, m_block.end(), 0);
+            process();
+        }
+        std::fill(m_block.begin() + m_used, m_block.begin() + 56, 0);
+        for (int i = 0; i < 8; ++i)
+            m_block[56 + i] = static_cast<unsigned char>(bits >> (56 - 8 * i));
+        process();
+
+        std::array<unsigned char, 20> digest;
+        for (int i = 0; i < 20; ++i)
+            digest[i] = static_cast<unsigned char>(m_state[i / 4] >> (24 - 8 * (i % 4)));
+        return digest;
+    }
+
+private:
+    static std::uint32_t rotate(std::uint32_t x, int n) noexcept
+    {
+        return x << n | x >> (32 - n);
+    }
+
+    void process() noexcept
+    {
+        std::uint32_t w[80];
+        for (int i = 0; i < 16; ++i)
+            w[i] = std::uint32_t { m_block[4 * i] } << 24 | std::uint32_t { m_block[4 * i + 1] } << 16 | std::uint32_t { m_block[4 * i + 2] } << 8 | m_block[4 * i + 3];
+        for (int i = 16; i < 80; ++i)
+            w[i] = rotate(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+        std::uint32_t a = m_state[0], b = m_state[1], c = m_state[2], d = m_state[3], e = m_state[4];
+        for (int i = 0; i < 80; ++i) {
+            std::uint32_t f, k;
+            if (i < 20) {
+                f = (b & c) | (~b & d);
+                k = 0x5a827999;
+            } else if (i < 40) {
+                f = b ^ c ^ d;
+                k = 0x6ed9eba1;
+            } else if (i < 60) {
+                f = (b & c) | (b & d) | (c & d);
+                k = 0x8f1bbcdc;
+            } else {
+                f = b ^ c ^ d;
+                k = 0xca62c1d6;
+            }
+            std::uint32_t t = rotate(a, 5) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = rotate(b, 30);
+            b = a;
+            a = t;
+        }
+        m_state[0] += a;
+        m_state[1] += b;
+        m_state[2] += c;
+        m_state[3] += d;
+        m_state[4] += e;
+        m_used = 0;
+    }
+
+    std::array<std::uint32_t, 5> m_state { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0 };
+    std::array<unsigned char, 64> m_block {};
+    std::size_t m_used = 0;
+    std::uint64_t m_length = 0;
+};
+
+std::string base64(const unsigned char* data, std::size_t size)
+{
+    static constexpr char digits[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    out.reserve((size + 2) / 3 * 4);
+    for (std::size_t i = 0; i < size; i += 3) {
+        std::uint32_t group = std::uint32_t { data[i] } << 16;
+        if (i + 1 < size)
+            group |= std::uint32_t { data[i + 1] } << 8;
+        if (i + 2 < size)
+            group |= data[i + 2];
+        out.push_back(digits[group >> 18 & 0x3f]);
+        out.push_back(digits[group >> 12 & 0x3f]);
+        out.push_back(i + 1 < size ? digits[group >> 6 & 0x3f] : '=');
+        out.push_back(i + 2 < size ? digits[group & 0x3f] : '=');
+    }
+    return out;
+}
+
+// whether the comma separated list has token, as "Connection: keep-alive, Upgrade"
+bool has_token(std::string_view list, std::string_view token) noexcept
+{
+    while (!list.empty()) {
+        std::size_t comma = list.find(',');
+        std::string_view item = list.substr(0, comma);
+        list = comma == std::string_view::npos ? std::string_view {} : list.substr(comma + 1);
+
+        std::size_t first = item.find_first_not_of(" \t");
+        if (first == std::string_view::npos)
+            continue;
+        item = item.substr(first, item.find_last_not_of(" \t") - first + 1);
+        if (net::http::iequals(item, token))
+            return true;
+    }
+    return false;
+}
+
+}
+
+const std::error_category& net::websocket::category() noexcept
+{
+    return websocket_error_category;
+}
+
+std::size_t net::websocket::parse(std::string_view buffer, frame_header& header)
+{
+    std::error_code e;
+    std::size_t size = parse(buffer, header, e);
+    THROW_IF_ERROR(e);
+    return size;
+}
+
+std::size_t net::websocket::parse(std::string_view buffer, frame_header& header, std::error_code& e) noexcept
+{
+    e.clear();
+    if (buffer.size() < 2)
+        return 0;
+    auto byte = [&](std::size_t i) { return static_cast<unsigned char>(buffer[i]); };
+
+    // no extension defines the reserved bits
+    if (byte(0) & 0x70) {
+        e = errc::bad_frame;
+        return 0;
+    }
+    header.fin = byte(0) & 0x80;
+    header.op = static_cast<opcode>(byte(0) & 0x0f);
+    switch (header.op) {
+    case opcode::continuation:
+    case opcode::text:
+    case opcode::binary:
+    case opcode::close:
+    case opcode::ping:
+    case opcode::pong:
+        break;
+    default:
+        e = errc::bad_opcode;
+        return 0;
+    }
+    header.masked = byte(1) & 0x80;
+
+    std::size_t size = 2;
+    std::uint64_t length = byte(1) & 0x7f;
+    if (length == 126) {
+        if (buffer.size() < 4)
+            return 0;
+        length = std::uint64_t { byte(2) } << 8 | byte(3);
+        size = 4;
+    } else if (length == 127) {
+        if (buffer.size() < 10)
+            return 0;
+        length = 0;
+        for (std::size_t i = 2; i < 10; ++i)
+            length = length << 8 | byte(i);
+        if (length >> 63) {
+            e = errc::bad_frame;
+            return 0;
+        }
+        size = 10;
+    }
+    if (is_control(header.op) && (!header.fin || length > max_control_payload)) {
+        e = errc::bad_control_frame;
+        return 0;
+    }
+    header.length = length;
+
+    if (header.masked) {
+        if (buffer.size() < size + 4)
+            return 0;
+        std::memcpy(header.key.data(), buffer.data() + size, 4);
+        size += 4;
+    }
+    return size;
+}
+
+void net::websocket::mask(void* data, std::size_t size, mask_key key, std::size_t offset) noexcept
+{
+    // the key as it applies from data on
+    std::rotate(key.begin(), key.begin() + offset % 4, key.end());
+    std::uint32_t rotated;
+    std::memcpy(&rotated, key.data(), 4);
+    mask_bytes(static_cast<unsigned char*>(data), size, rotated);
+}
+
+std::size_t net::websocket::encode_header(char* out, opcode op, std::uint64_t length, bool fin, const mask_key* key) noexcept
+{
+    auto* p = reinterpret_cast<unsigned char*>(out);
+    p[0] = static_cast<unsigned char>((fin ? 0x80 : 0) | static_cast<std::uint8_t>(op));
+    unsigned char masked = key ? 0x80 : 0;
+
+    std::size_t size;
+    if (length < 126) {
+        p[1] = static_cast<unsigned char>(masked | length);
+        size = 2;
+    } else if (length <= 0xffff) {
+        p[1] = masked | 126;
+        p[2] = static_cast<unsigned char>(length >> 8);
+        p[3] = static_cast<unsigned char>(length);
+        size = 4;
+    } else {
+        p[1] = masked | 127;
+        for (std::size_t i = 0; i < 8; ++i)
+            p[2 + i] = static_cast<unsigned char>(length >> (56 - 8 * i));
+        size = 10;
+    }
+    if (key) {
+        std::memcpy(p + size, key->data(), 4);
+        size += 4;
+    }
+    return size;
+}
+
+void net::websocket::append_frame(std::string& out, opcode op, std::string_view payload, bool fin)
+{
+    char header[max_header_size];
+    out.append(header, encode_header(header, op, payload.size(), fin));
+    out.append(payload);
+}
+
+void net::websocket::append_frame(std::string& out, opcode op, std::string_view payload, mask_key key, bool fin)
+{
+    char header[max_header_size];
+    out.append(header, encode_header(header, op, payload.size(), fin, &key));
+    std::size_t start = out.size();
+    out.append(payload);
+    mask(out.data() + start, payload.size(), key);
+}
+
+std::string_view net::websocket::upgrade_key(const http::request& req)
+{
+    std::error_code e;
+    std::string_view key = upgrade_key(req, e);
+    THROW_IF_ERROR(e);
+    return key;
+}
+
+std::string_view net::websocket::upgrade_key(const http::request& req, std::error_code& e) noexcept
+{
+    e.clear();
+    std::string_view key = req.headers.find("Sec-WebSocket-Key");
+    // 16 bytes, in base64
+    if (req.method != "GET" || req.minor_version < 1
+        || !has_token(req.headers.find("Upgrade"), "websocket")
+        || !has_token(req.headers.find("Connection"), "upgrade")
+        || req.headers.find("Sec-WebSocket-Version") != "13"
+        || key.size() != 24) {
+        e = errc::bad_handshake;
+        return {};
+    }
+    return key;
+}
+
+std::string net::websocket::accept_key(std::string_view key)
+{
+    sha1 hash;
+    hash.update(key);
+    hash.update("258EAFA5-E914-47DA-95CA-C5AB0DC85B11");
+    std::array<unsigned char, 20> digest = hash.finish();
+    return base64(digest.data(), digest.size());
+}
+
+void net::websocket::append_handshake_response(std::string& out, std::string_view key)
+{
+    out.append("HTTP/1.1 101 Switching Protocols\r\n"
+               "Upgrade: websocket\r\n"
+               "Connection: Upgrade\r\n"
+               "Sec-WebSocket-Accept: ");
+    out.append(accept_key(key));
+    out.append("\r\n\r\n");
+}
+
+std::vector<char> net::websocket::buffer_pool::acquire()
+{
+    std::lock_guard lock { m_mutex };
+    if (m_buffers.empty())
+        return {};
+    std::vector<char> buffer = std::move(m_buffers.back());
+    m_buffers.pop_back();
+    return buffer;
+}
+
+void net::websocket::buffer_pool::release(std::vector<char>&& buffer) noexcept
+{
+    if (buffer.capacity() == 0 || buffer.capacity() > m_max_capacity)
+        return;
+    buffer.clear();
+    std::lock_guard lock { m_mutex };
+    if (m_buffers.size() < m_max_buffers) {
+        try {
+            m_buffers.push_back(std::move(buffer));
+        } catch (...) {
+            // it's freed instead
+        }
+    }
+}
+
+std::size_t net::websocket::buffer_pool::size() const noexcept
+{
+    std::lock_guard lock { m_mutex };
+    return m_buffers.size();
+}
+
+net::websocket::assembler::~assembler() noexcept
+{
+    m_pool.release(std::move(m_buffer));
+}
+
+std::size_t net::websocket::assembler::feed(char* data, std::size_t size, std::error_code& e)
+{
+    e.clear();
+    m_ready = false;
+    m_pending = 0;
+    if (m_release) {
+        m_pool.release(std::move(m_buffer));
+        m_buffer = {};
+        m_release = false;
+    }
+
+    std::size_t used = 0;
+    while (used < size) {
+        frame_header header;
+        std::size_t header_size = parse({ data + used, size - used }, header, e);
+        if (e || header_size == 0)
+            return used;
+        if (header.masked != m_options.masked) {
+            e = errc::bad_masking;
+            return used;
+        }
+        if (header.length > m_options.max_message_size) {
+            e = errc::message_too_big;
+            return used;
+        }
+        auto length = static_cast<std::size_t>(header.length);
+        if (size - used - header_size < length) {
+            m_pending = header_size + length;
+            return used;
+        }
+
+        char* payload = data + used + header_size;
+        if (header.masked)
+            mask(payload, length, header.key);
+
+        if (is_control(header.op)) {
+            used += header_size + length;
+            m_message = { header.op, { payload, length } };
+            m_ready = true;
+            return used;
+        }
+        if ((header.op == opcode::continuation) != m_fragmented) {
+            e = errc::bad_continuation;
+            return used;
+        }
+        used += header_size + length;
+
+        if (!m_fragmented) {
+            if (header.fin) {
+                m_message = { header.op, { payload, length } };
+                m_ready = true;
+                return used;
+            }
+            m_buffer = m_pool.acquire();
+            m_type = header.op;
+            m_fragmented = true;
+        }
+        if (m_buffer.size() + length > m_options.max_message_size) {
+            e = errc::message_too_big;
+            return used;
+        }
+        m_buffer.insert(m_buffer.end(), payload, payload + length);
+        if (header.fin) {
+            m_fragmented = false;
+            m_release = true;
+            m_message = { m_type, { m_buffer.data(), m_buffer.size() } };
+            m_ready = true;
+            return used;
+        }
+    }
+    return used;
+}
+
+std::size_t net::websocket::send(socket& sock, const frame& f, std::size_t offset, int flags)
+{
+    std::error_code e;
+    std::size_t sent = send(sock, f, offset, flags, e);
+    THROW_IF_ERROR(e);
+    return sent;
+}
+
+std::size_t net::websocket::send(socket& sock, const frame& f, std::size_t offset, int flags, std::error_code& e) noexcept
+{
+    std::string_view header = f.header();
+    std::string_view payload = f.payload();
+    if (offset < header.size()) {
+        header.remove_prefix(offset);
+    } else {
+        payload.remove_prefix(std::min(offset - header.size(), payload.size()));
+        header = {};
+    }
+
+#ifndef _WIN32
+    iovec pieces[2] {
+        { const_cast<char*>(header.data()), header.size() },
+        { const_cast<char*>(payload.data()), payload.size() },
+    };
+    msghdr message {};
+    message.msg_iov = header.empty() ? pieces + 1 : pieces;
+    message.msg_iovlen = header.empty() ? 1 : 2;
+    return sock.sendmsg(&message, flags, e);
+#else
+    WSABUF pieces[2] {
+        { static_cast<ULONG>(header.size()), const_cast<char*>(header.data()) },
+        { static_cast<ULONG>(payload.size()), const_cast<char*>(payload.data()) },
+    };
+    DWORD sent = 0;
+    if (::WSASend(sock.native_handle(), header.empty() ? pieces + 1 : pieces, header.empty() ? 1 : 2, &sent, static_cast<DWORD>(flags), nullptr, nullptr) != 0) {
+        e.assign(::WSAGetLastError(), std::system_category());
+        return 0;
+    }
+    e.clear();
+    return sent;
+#endif
+}
+
+std::size_t net::websocket::broadcast(const frame& f, socket* const* recipients, std::size_t count, delivery* results) noexcept
+{
+    // sockets on windows must be non blocking already
+#ifdef MSG_DONTWAIT
+    int flags = MSG_DONTWAIT;
+#else
+    int flags = 0;
+#endif
+#ifdef MSG_NOSIGNAL
+    flags |= MSG_NOSIGNAL;
+#endif
+
+    std::size_t complete = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        delivery& result = results[i];
+        result.sent = 0;
+        result.error.clear();
+        while (result.sent < f.size()) {
+            std::size_t sent = send(*recipients[i], f, result.sent, flags, result.error);
+            if (result.error == std::errc::interrupted)
+                continue;
+            if (result.error == std::errc::operation_would_block || result.error == std::errc::resource_unavailable_try_again) {
+                result.error.clear(); // it has the rest to send later
+                break;
+            }
+            if (result.error)
+                break;
+            result.sent += sent;
+        }
+        if (result.sent == f.size())
+            ++complete;
+    }
+    return complete;
+}